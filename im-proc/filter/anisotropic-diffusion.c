@@ -0,0 +1,289 @@
+/**
+ * @file  anisotropic-diffusion.c
+ * @brief n iterations of the anisotropic diffusion of Perona and Malik
+ *        u += dt sum c(|d|) d, over the differences d between each pixel
+ *        and its four neighbours, with dt = 1/4 and Neumann borders
+ *
+ * The conductance c is 1 (function 0, the heat equation), 1/(1+(d/l)^2)
+ * (function 1) or exp(-(d/l)^2) (function 2), so that the diffusion stops
+ * at the edges, whose differences are large compared to lambda.
+ *
+ * The planes are cut into horizontal bands, one per worker thread
+ * (ANISOTROPIC_THREADS, the number of online processors by default). The
+ * workers are created once and sweep their band of the three planes from
+ * one buffer into the other at each step, the two buffers being swapped
+ * after a barrier, so that nothing is allocated during the iterations.
+ *
+ * The mean absolute change of the pixels and the time of each step are
+ * reported, and can be saved as a CSV table with one line per step.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include <bcl.h>
+
+struct job
+{
+  int                rows;
+  int                cols;
+  int                n;
+  int                function;
+  float              k2;      /* lambda^2 */
+  int                threads;
+  float             *a;
+  float             *b;
+  double            *change;  /* sum of |change| of each step and worker */
+  double            *ms;      /* end time of each step */
+  pthread_barrier_t  barrier;
+};
+
+struct worker
+{
+  struct job *job;
+  int         rank;
+};
+
+static double
+L_now_ms(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return 1000.0*t.tv_sec + t.tv_nsec/1e6;
+}
+
+/**
+ * @brief the fluxes c(|d|) d through the edge to a neighbour
+ */
+static inline float
+L_heat(float d, float k2)
+{
+  (void)k2;
+  return d;
+}
+
+static inline float
+L_fraction(float d, float k2)
+{
+  return d/(1 + d*d/k2);
+}
+
+static inline float
+L_exponential(float d, float k2)
+{
+  return d*expf(-d*d/k2);
+}
+
+/*
+ * One step on the rows [r0, r1[ of a plane, from a into b, with the flux
+ * function flux, adding the absolute changes to change. The sweep is
+ * expanded once per conductance so that the pixel loop does not dispatch.
+ */
+#define SWEEP(flux)							\
+  for(int i = r0; i < r1; i++){						\
+    /* The differences to the neighbours outside of the plane are 0 */	\
+    const float *c = a + i*cols;					\
+    const float *u = a + (i > 0 ? i-1 : i)*cols;			\
+    const float *d = a + (i < rows-1 ? i+1 : i)*cols;			\
+    float       *o = b + i*cols;					\
+    for(int j = 0; j < cols; j++){					\
+      float x = c[j];							\
+      float s = flux(u[j] - x, k2) + flux(d[j] - x, k2)			\
+	+ flux(c[j > 0 ? j-1 : j] - x, k2)				\
+	+ flux(c[j < cols-1 ? j+1 : j] - x, k2);			\
+      o[j] = x + 0.25f*s;						\
+      change += fabsf(0.25f*s);						\
+    }									\
+  }
+
+/**
+ * @brief one step on the rows [r0, r1[ of a plane, from a into b
+ * @return the sum of the absolute changes
+ */
+static double
+L_sweep(struct job *job, const float *a, float *b, int r0, int r1)
+{
+  int    rows   = job->rows;
+  int    cols   = job->cols;
+  float  k2     = job->k2;
+  double change = 0;
+
+  switch(job->function){
+  case 0:
+    SWEEP(L_heat);
+    break;
+  case 1:
+    SWEEP(L_fraction);
+    break;
+  default:
+    SWEEP(L_exponential);
+  }
+  return change;
+}
+
+static void *
+work(void *arg)
+{
+  struct worker *self = arg;
+  struct job    *job  = self->job;
+  int            k    = self->rank;
+  int            size = job->rows*job->cols;
+  int            r0   = k*job->rows/job->threads;
+  int            r1   = (k+1)*job->rows/job->threads;
+  float         *a    = job->a;
+  float         *b    = job->b;
+
+  for(int t = 0; t < job->n; t++){
+    double change = 0;
+    for(int c = 0; c < 3; c++)
+      change += L_sweep(job, a + c*size, b + c*size, r0, r1);
+    job->change[t*job->threads + k] = change;
+    pthread_barrier_wait(&job->barrier);
+    if(k == 0)
+      job->ms[t] = L_now_ms();
+    float *tmp = a;
+    a = b;
+    b = tmp;
+  }
+  return NULL;
+}
+
+/**
+ * @brief number of worker threads, from ANISOTROPIC_THREADS or the number
+ *        of online processors
+ */
+static int
+L_threads(void)
+{
+  char *env = getenv("ANISOTROPIC_THREADS");
+  int   n   = env != NULL ? atoi(env) : (int)sysconf(_SC_NPROCESSORS_ONLN);
+  return n > 0 ? n : 1;
+}
+
+/**
+ * @brief save the change and time of each step as a CSV table
+ */
+static void
+L_save_stats(struct job *job, double start, FILE *f)
+{
+  fprintf(f, "step,change,ms\n");
+  for(int t = 0; t < job->n; t++){
+    double change = 0;
+    for(int k = 0; k < job->threads; k++)
+      change += job->change[t*job->threads + k];
+    fprintf(f, "%d,%.6f,%.3f\n", t+1, change/(3.0*job->rows*job->cols),
+	    job->ms[t] - (t > 0 ? job->ms[t-1] : start));
+  }
+  fclose(f);
+}
+
+void
+process(int n, float lambda, int function, char *ims, char *imd, char *csv)
+{
+  pnm        img  = pnm_load(ims);
+  int        cols = pnm_get_width(img);
+  int        rows = pnm_get_height(img);
+  int        size = rows*cols;
+  struct job job;
+  // Opened before the iterations, so that a bad path fails at once
+  FILE      *f    = NULL;
+
+  if(csv != NULL && (f = fopen(csv, "w")) == NULL){
+    fprintf(stderr, "Cannot open %s\n", csv);
+    exit(EXIT_FAILURE);
+  }
+  job.rows     = rows;
+  job.cols     = cols;
+  job.n        = n;
+  job.function = function;
+  job.k2       = lambda*lambda;
+  job.threads  = L_threads() < rows ? L_threads() : rows;
+  job.a        = memory_alloc(3*size*sizeof(float));
+  job.b        = memory_alloc(3*size*sizeof(float));
+  job.change   = memory_alloc((n*job.threads + 1)*sizeof(double));
+  job.ms       = memory_alloc((n + 1)*sizeof(double));
+  pthread_barrier_init(&job.barrier, NULL, job.threads);
+
+  for(int c = 0; c < 3; c++)
+    for(int i = 0; i < rows; i++)
+      for(int j = 0; j < cols; j++)
+	job.a[c*size + i*cols + j] = pnm_get_component(img, i, j, c);
+
+  double         start   = L_now_ms();
+  pthread_t     *tids    = memory_alloc(job.threads*sizeof(pthread_t));
+  struct worker *workers = memory_alloc(job.threads*sizeof(struct worker));
+  for(int k = 0; k < job.threads; k++){
+    workers[k].job  = &job;
+    workers[k].rank = k;
+    if(k > 0)
+      pthread_create(&tids[k], NULL, work, &workers[k]);
+  }
+  work(&workers[0]);
+  for(int k = 1; k < job.threads; k++)
+    pthread_join(tids[k], NULL);
+  double ms = L_now_ms()-start;
+
+  fprintf(stderr, "anisotropic-diffusion: %d steps in %.3f ms", n, ms);
+  if(n > 0 && ms > 0){
+    double first = 0, last = 0;
+    for(int k = 0; k < job.threads; k++){
+      first += job.change[k];
+      last  += job.change[(n-1)*job.threads + k];
+    }
+    fprintf(stderr, " (%.3f ms/step, %.1f Mpixel/s, %d threads)",
+	    ms/n, (double)n*size/(1000.0*ms), job.threads);
+    fprintf(stderr, ", mean change %.4f -> %.4f",
+	    first/(3.0*size), last/(3.0*size));
+  }
+  fprintf(stderr, "\n");
+  if(f != NULL)
+    L_save_stats(&job, start, f);
+
+  // After an odd number of steps, the result is in the second buffer
+  float *res = n%2 ? job.b : job.a;
+  for(int c = 0; c < 3; c++)
+    for(int i = 0; i < rows; i++)
+      for(int j = 0; j < cols; j++){
+	float v = res[c*size + i*cols + j];
+	pnm_set_component(img, i, j, c, v < 0 ? 0 : v > pnm_maxval ?
+			  pnm_maxval : (unsigned short)(v + 0.5));
+      }
+  pnm_save(img, PnmRawPpm, imd);
+
+  pthread_barrier_destroy(&job.barrier);
+  memory_free(tids);
+  memory_free(workers);
+  memory_free(job.a);
+  memory_free(job.b);
+  memory_free(job.change);
+  memory_free(job.ms);
+  pnm_free(img);
+}
+
+void
+usage (char *s){
+  fprintf(stderr, "Usage: %s <n> <lambda> <function> <ims> <imd> ", s);
+  fprintf(stderr, "[<stats.csv>]\n");
+  fprintf(stderr, "function: 0 (heat equation), 1 (1/(1+(d/l)^2)) or ");
+  fprintf(stderr, "2 (exp(-(d/l)^2))\n");
+  exit(EXIT_FAILURE);
+}
+
+#define PARAM 5
+int
+main(int argc, char *argv[]){
+  if (argc != PARAM+1 && argc != PARAM+2) usage(argv[0]);
+  int   n        = atoi(argv[1]);
+  float lambda   = atof(argv[2]);
+  int   function = atoi(argv[3]);
+  if (n < 0 || lambda <= 0 || function < 0 || function > 2) usage(argv[0]);
+  process(n, lambda, function, argv[4], argv[5],
+	  argc > PARAM+1 ? argv[6] : NULL);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,150 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "bank.h"
+
+/*
+ * The gains of a transfer function are built once per function, image
+ * size and parameters. The radial functions only depend on the distance
+ * to the null frequency, so only the quadrant of the non-negative
+ * frequencies is evaluated, row u of the half spectrum being copied to
+ * row -u. The notch is only symmetric about the null frequency and is
+ * evaluated on the whole half spectrum. The cache is released by
+ * bank_clear(), run at exit.
+ */
+struct bank_entry
+{
+  transfer  apply;
+  int       rows;
+  int       cols;
+  int       params[5];
+  float    *gain;
+};
+
+static struct bank_entry *bank          = NULL;
+static int                bank_size     = 0;
+static int                bank_capacity = 0;
+static int                registered    = 0;   /* bank_clear at exit */
+
+/**
+ * @brief distance of the frequency (u, v) to (u0, v0)
+ */
+static float
+dist(int u, int v, int u0, int v0)
+{
+  return sqrt((double)(u-u0)*(u-u0) + (double)(v-v0)*(v-v0));
+}
+
+float
+lowpass(int u, int v, int d0, int n, int w, int u0, int v0){
+  (void)w;
+  (void)u0;
+  (void)v0;
+  return 1/(1 + pow(dist(u, v, 0, 0)/d0, 2*n));
+}
+
+float
+highpass(int u, int v, int d0, int n, int w, int u0, int v0){
+  (void)w;
+  (void)u0;
+  (void)v0;
+  float d = dist(u, v, 0, 0);
+  if(d == 0)
+    return 0.0;
+  return 1/(1 + pow(d0/d, 2*n));
+}
+
+float
+bandreject(int u, int v, int d0, int n, int w, int u0, int v0){
+  (void)u0;
+  (void)v0;
+  float d  = dist(u, v, 0, 0);
+  float dd = d*d - (float)d0*d0;
+  if(dd == 0)
+    return 0.0;
+  return 1/(1 + pow(d*w/dd, 2*n));
+}
+
+float
+bandpass(int u, int v, int d0, int n, int w, int u0, int v0){
+  return 1 - bandreject(u, v, d0, n, w, u0, v0);
+}
+
+float
+notch(int u, int v, int d0, int n, int w, int u0, int v0){
+  (void)w;
+  // The notch and its symmetric, for the filtered image to stay real
+  float d1 = dist(u, v, u0, v0);
+  float d2 = dist(u, v, -u0, -v0);
+  if(d1 == 0 || d2 == 0)
+    return 0.0;
+  return 1/(1 + pow((float)d0*d0/(d1*d2), n));
+}
+
+static float *
+build(transfer apply, int rows, int cols, const int *p)
+{
+  int    hcols  = cols/2+1;
+  int    radial = apply != notch;
+  int    last   = radial ? rows/2 : rows-1;
+  float *gain   = malloc(rows*hcols*sizeof(float));
+  if(gain == NULL){
+    fprintf(stderr, "Cannot allocate more memory (in build)\n");
+    exit(EXIT_FAILURE);
+  }
+
+  for(int i = 0; i <= last; i++){
+    int u = i <= rows/2 ? i : i - rows;
+    for(int v = 0; v < hcols; v++)
+      gain[i*hcols + v] = apply(u, v, p[0], p[1], p[2], p[3], p[4]);
+  }
+  if(radial)
+    for(int i = rows/2+1; i < rows; i++)
+      memcpy(gain + i*hcols, gain + (rows-i)*hcols, hcols*sizeof(float));
+  return gain;
+}
+
+const float
+*bank_gain(transfer apply, int rows, int cols,
+	   int d0, int n, int w, int u0, int v0)
+{
+  int p[5] = {d0, n, w, u0, v0};
+
+  for(int k = 0; k < bank_size; k++)
+    if(bank[k].apply == apply && bank[k].rows == rows &&
+       bank[k].cols == cols && !memcmp(bank[k].params, p, sizeof(p)))
+      return bank[k].gain;
+
+  if(!registered){
+    registered = 1;
+    atexit(bank_clear);
+  }
+  if(bank_size == bank_capacity){
+    bank_capacity = bank_capacity ? 2*bank_capacity : 8;
+    bank = realloc(bank, bank_capacity*sizeof(struct bank_entry));
+    if(bank == NULL){
+      fprintf(stderr, "Cannot allocate more memory (in bank_gain)\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  struct bank_entry *e = &bank[bank_size++];
+  e->apply = apply;
+  e->rows  = rows;
+  e->cols  = cols;
+  memcpy(e->params, p, sizeof(p));
+  e->gain  = build(apply, rows, cols, p);
+  return e->gain;
+}
+
+void
+bank_clear(void)
+{
+  for(int k = 0; k < bank_size; k++)
+    free(bank[k].gain);
+  free(bank);
+  bank          = NULL;
+  bank_size     = 0;
+  bank_capacity = 0;
+}
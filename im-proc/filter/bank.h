@@ -0,0 +1,57 @@
+/**
+ * @file bank.h
+ * @brief header for bank module that implements the Butterworth transfer
+ *        functions, and their gains over a half spectrum built once per
+ *        size and parameters and cached
+ */
+
+#ifndef BANK_H
+#define BANK_H
+
+/**
+ * @brief a transfer function
+ * @param int u, v: the signed frequency, the null one being (0, 0)
+ * @param int d0: the cut-off frequency
+ * @param int n: the order of the filter
+ * @param int w: the width of the band, for bandreject and bandpass
+ * @param int u0, v0: the notch frequency, for notch
+ * @return the gain of the frequency
+ */
+typedef float (*transfer)(int u, int v, int d0, int n, int w, int u0, int v0);
+
+extern float
+lowpass(int u, int v, int d0, int n, int w, int u0, int v0);
+
+extern float
+highpass(int u, int v, int d0, int n, int w, int u0, int v0);
+
+extern float
+bandreject(int u, int v, int d0, int n, int w, int u0, int v0);
+
+extern float
+bandpass(int u, int v, int d0, int n, int w, int u0, int v0);
+
+extern float
+notch(int u, int v, int d0, int n, int w, int u0, int v0);
+
+/**
+ * @brief get the gains of a transfer function over the half spectrum of an
+ *        image from the cache, building them on the first request
+ * @param transfer apply: the transfer function
+ * @param int rows: the image height
+ * @param int cols: the image width
+ * @param int d0, n, w, u0, v0: the parameters of the transfer function
+ * @return the rows*(cols/2+1) gains, in the order of apply_gain_fn, owned
+ *         by the cache
+ */
+extern const float
+*bank_gain(transfer apply, int rows, int cols,
+	   int d0, int n, int w, int u0, int v0);
+
+/**
+ * @brief release all the gains of the cache, done automatically at exit
+ */
+extern void
+bank_clear(void);
+
+#endif /* BANK_H */
@@ -0,0 +1,124 @@
+/**
+ * @file  bench-convolution.c
+ * @brief time the Gaussian blur of the red channel of the given images for
+ *        growing sigmas: the direct separable convolution by the sampled
+ *        kernel, the same through the FFT, the recursive filter and a box
+ *        blur of the same radius, whose costs do not depend on sigma.
+ *
+ * The largest difference between the direct and FFT results is reported
+ * for each sigma, and the radius from which the FFT is faster, the one
+ * conv_auto() should use as its crossover (rx+ry, CONV_CROSSOVER).
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <bcl.h>
+#include "fft.h"
+#include "convolution.h"
+
+static const float sigmas[] = {0.5, 1, 2, 3, 4, 6, 8, 12, 16, 24};
+
+double
+now_ms(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return 1000.0*t.tv_sec + t.tv_nsec/1e6;
+}
+
+int
+max_diff(int size, const unsigned short *a, const unsigned short *b)
+{
+  int d = 0;
+  for(int i = 0; i < size; i++)
+    if(abs(a[i]-b[i]) > d)
+      d = abs(a[i]-b[i]);
+  return d;
+}
+
+void
+run(char *name, int loops)
+{
+  pnm             ims   = pnm_load(name);
+  int             cols  = pnm_get_width(ims);
+  int             rows  = pnm_get_height(ims);
+  int             size  = rows*cols;
+  unsigned short *src   = memory_alloc(size*sizeof(unsigned short));
+  unsigned short *dir   = memory_alloc(size*sizeof(unsigned short));
+  unsigned short *fft   = memory_alloc(size*sizeof(unsigned short));
+  unsigned short *tmp   = memory_alloc(size*sizeof(unsigned short));
+  int             cross = -1;
+
+  for(int i = 0; i < rows; i++)
+    for(int j = 0; j < cols; j++)
+      src[i*cols + j] = pnm_get_component(ims, i, j, PnmRed);
+
+  printf("%s %dx%d\n", name, cols, rows);
+  printf("  sigma   r    direct       fft recursive       box  diff\n");
+  for(unsigned s = 0; s < sizeof(sigmas)/sizeof(*sigmas); s++){
+    int    r;
+    float *k = conv_gaussian_kernel(sigmas[s], &r);
+    double t[4];
+
+    // Once outside of the timing, for the FFT plans
+    conv_separable_fft(rows, cols, src, fft, k, r, k, r, BORDER_MIRROR);
+    for(int m = 0; m < 4; m++){
+      double start = now_ms();
+      for(int l = 0; l < loops; l++)
+	switch(m){
+	case 0:
+	  conv_separable(rows, cols, src, dir, k, r, k, r, BORDER_MIRROR);
+	  break;
+	case 1:
+	  conv_separable_fft(rows, cols, src, fft, k, r, k, r, BORDER_MIRROR);
+	  break;
+	case 2:
+	  conv_gaussian(rows, cols, src, tmp, sigmas[s]);
+	  break;
+	case 3:
+	  conv_box(rows, cols, src, tmp, r, r, BORDER_MIRROR);
+	  break;
+	}
+      t[m] = (now_ms()-start)/loops;
+    }
+    if(cross < 0 && t[1] < t[0])
+      cross = 2*r;
+    printf("  %5.1f %3d %9.2f %9.2f %9.2f %9.2f %5d\n", sigmas[s], r,
+	   t[0], t[1], t[2], t[3], max_diff(size, dir, fft));
+    memory_free(k);
+  }
+  if(cross < 0)
+    printf("  the direct convolution is always faster\n");
+  else
+    printf("  the FFT is faster from rx+ry = %d\n", cross);
+
+  memory_free(src);
+  memory_free(dir);
+  memory_free(fft);
+  memory_free(tmp);
+  pnm_free(ims);
+}
+
+void
+usage(char *s)
+{
+  fprintf(stderr, "%s <loops> <ims>...\n", s);
+  exit(EXIT_FAILURE);
+}
+
+int
+main(int argc, char *argv[])
+{
+  if(argc < 3)
+    usage(argv[0]);
+  int loops = atoi(argv[1]);
+  if(loops < 1)
+    usage(argv[0]);
+  for(int k = 2; k < argc; k++)
+    run(argv[k], loops);
+  return EXIT_SUCCESS;
+}
@@ -1,89 +1,70 @@
+/**
+ * @file  butterworth.c
+ * @brief Butterworth filtering of color images in the frequency domain.
+ *
+ * The three channels are transformed together into half spectra, whose
+ * bins are multiplied in place (apply_gain) by the gains of the transfer
+ * function of the filter, built once by the bank module, before the
+ * inverse transform.
+ */
 #include <stdlib.h>
 #include <string.h>
 #include <float.h>
-#include <math.h> 
+#include <math.h>
 
 #include <bcl.h>
 #include <fft.h>
+#include <bank.h>
 
-float
-lowpass(int u, int v, int d0, int n, int w, int u0, int v0){
-  (void)u;
-  (void)v;
-  (void)d0;
-  (void)n;
-  (void)w;
-  (void)u0;
-  (void)v0;  
-  return 0.0;
-}
+static const struct
+{
+  char     *name;
+  transfer  apply;
+} filters[] = {
+  {"lowpass",    lowpass},
+  {"highpass",   highpass},
+  {"bandreject", bandreject},
+  {"bandpass",   bandpass},
+  {"notch",      notch},
+};
 
-float
-highpass(int u, int v, int d0, int n, int w, int u0, int v0){
-  (void)u;
-  (void)v;
-  (void)d0;
-  (void)n;
-  (void)w;
-  (void)u0;
-  (void)v0;  
-  return 0.0;
-}
+void
+process(char* inp, char* out,
+	int d0, int n, int ww, int u0, int v0,
+	transfer apply)
+{
+  pnm ims  = pnm_load(inp);
+  int cols = pnm_get_width(ims);
+  int rows = pnm_get_height(ims);
+  int size = rows*cols;
 
-float
-bandreject(int u, int v, int d0, int n, int w, int u0, int v0){
-  (void)u;
-  (void)v;
-  (void)d0;
-  (void)n;
-  (void)w;
-  (void)u0;
-  (void)v0;  
-  return 0.0;
-}
+  unsigned short *planes = memory_alloc(3*size*sizeof(unsigned short));
+  for(int c = 0; c < 3; c++)
+    for(int i = 0; i < rows; i++)
+      for(int j = 0; j < cols; j++)
+	planes[c*size + i*cols + j] = pnm_get_component(ims, i, j, c);
 
-float
-bandpass(int u, int v, int d0, int n, int w, int u0, int v0){
-  (void)u;
-  (void)v;
-  (void)d0;
-  (void)n;
-  (void)w;
-  (void)u0;
-  (void)v0;  
-  return 0.0;
-}
+  fftw_complex *freq = forward_r2c_many(rows, cols, 3, planes);
+  apply_gain(rows*(cols/2+1), 3, freq,
+	     bank_gain(apply, rows, cols, d0, n, ww, u0, v0));
+  unsigned short *res = backward_c2r_many(rows, cols, 3, freq);
 
-float
-notch(int u, int v, int d0, int n, int w, int u0, int v0){
-  (void)u;
-  (void)v;
-  (void)d0;
-  (void)n;
-  (void)w;
-  (void)u0;
-  (void)v0;  
-  return 0.0;
-}
+  for(int c = 0; c < 3; c++)
+    for(int i = 0; i < rows; i++)
+      for(int j = 0; j < cols; j++)
+	pnm_set_component(ims, i, j, c, res[c*size + i*cols + j]);
+  pnm_save(ims, PnmRawPpm, out);
 
-void 
-process(char* inp, char* out, 
-	int d0, int nx2, int ww, int u0, int v0,
-	float (*apply)(int, int, int, int, int, int, int))  
-{
-  (void)inp;
-  (void)out;
-  (void)d0;
-  (void)nx2;
-  (void)ww;
-  (void)u0;
-  (void)v0;
-  (void)apply;  
+  memory_free(planes);
+  free(freq);
+  free(res);
+  pnm_free(ims);
 }
 
 void usage (char *s){
   fprintf(stderr, "Usage: %s <ims> <imd> <filter> ", s);
   fprintf(stderr, "<d0> <n> <w> <u0> <v0>\n");
+  fprintf(stderr, "filter: lowpass, highpass, bandreject, bandpass or notch\n");
   exit(EXIT_FAILURE);
 }
 
@@ -91,5 +72,18 @@ void usage (char *s){
 int
 main(int argc, char *argv[]){
   if (argc != param+1) usage(argv[0]);
-  return EXIT_SUCCESS;
+  int d0 = atoi(argv[4]);
+  int n  = atoi(argv[5]);
+  int w  = atoi(argv[6]);
+  int u0 = atoi(argv[7]);
+  int v0 = atoi(argv[8]);
+  if (d0 < 1 || n < 1) usage(argv[0]);
+
+  for (unsigned k = 0; k < sizeof(filters)/sizeof(*filters); k++)
+    if (!strcmp(argv[3], filters[k].name)){
+      process(argv[1], argv[2], d0, n, w, u0, v0, filters[k].apply);
+      return EXIT_SUCCESS;
+    }
+  usage(argv[0]);
+  return EXIT_FAILURE;
 }
@@ -0,0 +1,104 @@
+/**
+ * @file convolution.h
+ * @brief header for convolution module that implements the direct
+ *        convolution of grayscale planes: separable row and column passes,
+ *        arbitrary 2D kernels, box and recursive Gaussian blurs in a
+ *        constant time per pixel, and the convolution by separable
+ *        symmetric kernels through the FFT module, chosen automatically
+ *        from the kernel size
+ */
+
+#ifndef CONVOLUTION_H
+#define CONVOLUTION_H
+
+/**
+ * @brief the values of the pixels outside of the plane: zero, the nearest
+ *        border pixel, the mirror about the border pixel, or the periodic
+ *        repetition of the plane
+ */
+enum {BORDER_ZERO, BORDER_CLAMP, BORDER_MIRROR, BORDER_WRAP};
+
+/*
+ * The planes are rows*cols unsigned shorts, row major, the results being
+ * rounded and clamped to [0, pnm_maxval]. Kernels of radius r have 2r+1
+ * coefficients, the center one being k[r], and are applied as
+ * dst(i, j) = sum k[t+r] src(i, j+t) (a correlation, the same for the
+ * symmetric kernels).
+ */
+
+/**
+ * @brief convolve a plane by a separable kernel, rows then columns
+ * @param int rows, cols: the plane size
+ * @param unsigned short* src: the input plane
+ * @param unsigned short* dst: the output plane, can be src
+ * @param float* kx: the row kernel, of radius rx
+ * @param float* ky: the column kernel, of radius ry
+ * @param int border: the border mode
+ */
+extern void
+conv_separable(int rows, int cols, const unsigned short *src,
+	       unsigned short *dst, const float *kx, int rx,
+	       const float *ky, int ry, int border);
+
+/**
+ * @brief convolve a plane by a (2ry+1)x(2rx+1) kernel
+ * @param float* k: the kernel, row major, its center at (ry, rx)
+ */
+extern void
+conv_2d(int rows, int cols, const unsigned short *src, unsigned short *dst,
+	const float *k, int rx, int ry, int border);
+
+/**
+ * @brief mean of the (2ry+1)x(2rx+1) window of each pixel, with running
+ *        sums whose cost does not depend on the radii
+ */
+extern void
+conv_box(int rows, int cols, const unsigned short *src, unsigned short *dst,
+	 int rx, int ry, int border);
+
+/**
+ * @brief Gaussian blur by the recursive filter of Young and van Vliet, a
+ *        causal and an anti-causal third order pass in each direction whose
+ *        cost does not depend on sigma, the borders being clamped
+ *
+ * The filter only approximates the Gaussian, and poorly for small sigmas:
+ * compared with the exact blur, it is off by up to 11 grey levels on
+ * natural images and 18 on noise up to sigma = 1, and by at most 7 and 4
+ * from sigma = 2. For small sigmas, conv_separable() with the kernel of
+ * conv_gaussian_kernel() is exact and faster.
+ * @param float sigma: the standard deviation, at least 0.5
+ */
+extern void
+conv_gaussian(int rows, int cols, const unsigned short *src,
+	      unsigned short *dst, float sigma);
+
+/**
+ * @brief the sampled and normalized Gaussian kernel of radius ceil(3 sigma)
+ * @param float sigma: the standard deviation
+ * @param int* r: the radius output
+ * @return the 2r+1 coefficients, to free with memory_free
+ */
+extern float
+*conv_gaussian_kernel(float sigma, int *r);
+
+/**
+ * @brief convolve a plane by a separable symmetric kernel through the FFT,
+ *        the plane being padded by the radii with the border mode so that
+ *        the result is the same as the direct one
+ */
+extern void
+conv_separable_fft(int rows, int cols, const unsigned short *src,
+		   unsigned short *dst, const float *kx, int rx,
+		   const float *ky, int ry, int border);
+
+/**
+ * @brief convolve a plane by a separable kernel, directly when rx+ry is at
+ *        most the crossover radius (CONV_CROSSOVER, measured by
+ *        bench-convolution by default) or when the kernel is not
+ *        symmetric, through the FFT otherwise
+ */
+extern void
+conv_auto(int rows, int cols, const unsigned short *src, unsigned short *dst,
+	  const float *kx, int rx, const float *ky, int ry, int border);
+
+#endif /* CONVOLUTION_H */
@@ -1,45 +1,421 @@
+#define _POSIX_C_SOURCE 200112L
+
 #include <float.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
+#include <unistd.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include "fft.h"
 
+/*
+ * Plans are cached by size, number of transforms, kind, in-place and
+ * alignment of the arrays, and run on the caller's arrays with the new-array execute
+ * interface, so repeated transforms of the same size skip planning. They
+ * are built with the planner given by FFT_PLANNER (estimate, measure or
+ * patient, measure by default) on scratch arrays. The wisdom is loaded from
+ * the file given by FFT_WISDOM before the first plan, and again after each
+ * fft_cleanup() since fftw_cleanup() forgets it, and saved back by
+ * fft_cleanup(), run at exit. The default name is fft.wisdom, relative to
+ * the current directory, so every program using the module writes it
+ * where it is run; an empty name disables the persistence.
+ *
+ * When built with HAVE_FFTW_THREADS (the Makefile defines it when
+ * fftw3_threads links), plans run on the number of threads given by
+ * fft_set_threads(), FFT_THREADS or the number of online processors, the
+ * count being part of the cache key. Otherwise every plan is sequential.
+ *
+ * The real transforms work on howmany planes stored one after the other
+ * (the channels of a color image), all of them transformed by one plan.
+ * Their scratch arrays are kept between calls and grown as needed, so that
+ * repeated transforms do not map and fault fresh pages each time.
+ */
+enum {C2C_FORWARD, C2C_BACKWARD, R2C, C2R};
+
+struct plan_entry
+{
+  int       rows;
+  int       cols;
+  int       kind;
+  int       howmany;
+  int       inplace;
+  int       aligned;
+  int       threads;
+  fftw_plan plan;
+};
+
+static struct plan_entry *plans          = NULL;
+static int                plans_size     = 0;
+static int                plans_capacity = 0;
+static int                wisdom_loaded  = 0;
+static int                wisdom_dirty   = 0;
+static int                registered     = 0;   /* fft_cleanup at exit */
+static int                threaded       = 0;
+static int                threads_init   = 0;
+static int                nthreads       = 0;
+static void              *work[2]        = {NULL, NULL};
+static size_t             work_size[2]   = {0, 0};
+
+static const char *
+wisdom_file(void)
+{
+  const char *name = getenv("FFT_WISDOM");
+  return name != NULL ? name : "fft.wisdom";
+}
+
+static unsigned
+planner_flags(void)
+{
+  const char *planner = getenv("FFT_PLANNER");
+  if(planner == NULL || !strcmp(planner, "measure"))
+    return FFTW_MEASURE;
+  if(!strcmp(planner, "estimate"))
+    return FFTW_ESTIMATE;
+  if(!strcmp(planner, "patient"))
+    return FFTW_PATIENT;
+  fprintf(stderr, "Unknown FFT_PLANNER %s, using measure\n", planner);
+  return FFTW_MEASURE;
+}
+
+static void *
+get_work(int k, size_t size)
+{
+  if(work_size[k] < size){
+    fftw_free(work[k]);
+    work[k]      = fftw_malloc(size);
+    work_size[k] = size;
+    if(work[k] == NULL){
+      fprintf(stderr, "Cannot allocate more memory (in get_work)\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  return work[k];
+}
+
+static int
+default_threads(void)
+{
+  const char *env = getenv("FFT_THREADS");
+  int n = env != NULL ? atoi(env) : (int)sysconf(_SC_NPROCESSORS_ONLN);
+  return n > 0 ? n : 1;
+}
+
+int
+fft_set_threads(int n)
+{
+  // fftw_init_threads must come before any other FFTW call
+  if(!threads_init){
+    threads_init = 1;
+#ifdef HAVE_FFTW_THREADS
+    threaded = fftw_init_threads();
+    if(!threaded)
+      fprintf(stderr, "Cannot initialize FFTW threads, using one\n");
+#endif
+  }
+  nthreads = threaded ? (n > 0 ? n : default_threads()) : 1;
+  return nthreads;
+}
+
+static fftw_plan
+get_plan(int rows, int cols, int kind, int howmany, void *in, void *out)
+{
+  if(nthreads == 0)
+    fft_set_threads(0);
+
+  int inplace = in == out;
+  int aligned = fftw_alignment_of((double *)in) == 0 &&
+    fftw_alignment_of((double *)out) == 0;
+
+  for(int k = 0; k < plans_size; k++)
+    if(plans[k].rows == rows && plans[k].cols == cols &&
+       plans[k].kind == kind && plans[k].howmany == howmany &&
+       plans[k].inplace == inplace &&
+       plans[k].aligned == aligned && plans[k].threads == nthreads)
+      return plans[k].plan;
+
+  if(!wisdom_loaded){
+    wisdom_loaded = 1;
+    if(*wisdom_file())
+      fftw_import_wisdom_from_filename(wisdom_file());
+    if(!registered){
+      registered = 1;
+      atexit(fft_cleanup);
+    }
+  }
+  if(plans_size == plans_capacity){
+    plans_capacity = plans_capacity ? 2*plans_capacity : 8;
+    plans = realloc(plans, plans_capacity*sizeof(struct plan_entry));
+  }
+  // The planner may overwrite its arrays, hence the scratch ones
+  fftw_complex *s_in  = fftw_alloc_complex(howmany*rows*cols);
+  fftw_complex *s_out = inplace ? s_in : fftw_alloc_complex(howmany*rows*cols);
+  if(plans == NULL || s_in == NULL || s_out == NULL){
+    fprintf(stderr, "Cannot allocate more memory (in get_plan)\n");
+    exit(EXIT_FAILURE);
+  }
+  unsigned flags = planner_flags() | (aligned ? 0 : FFTW_UNALIGNED);
+  int      n[2]  = {rows, cols};
+  struct plan_entry *e = &plans[plans_size++];
+  e->rows    = rows;
+  e->cols    = cols;
+  e->kind    = kind;
+  e->howmany = howmany;
+  e->inplace = inplace;
+  e->aligned = aligned;
+  e->threads = nthreads;
+#ifdef HAVE_FFTW_THREADS
+  if(threaded)
+    fftw_plan_with_nthreads(nthreads);
+#endif
+  switch(kind){
+  case C2C_FORWARD:
+    e->plan = fftw_plan_dft_2d(rows, cols, s_in, s_out, FFTW_FORWARD, flags);
+    break;
+  case C2C_BACKWARD:
+    e->plan = fftw_plan_dft_2d(rows, cols, s_in, s_out, FFTW_BACKWARD, flags);
+    break;
+  case R2C:
+    e->plan = fftw_plan_many_dft_r2c(2, n, howmany,
+				     (double *)s_in, NULL, 1, rows*cols,
+				     s_out, NULL, 1, rows*(cols/2+1), flags);
+    break;
+  case C2R:
+    e->plan = fftw_plan_many_dft_c2r(2, n, howmany,
+				     s_in, NULL, 1, rows*(cols/2+1),
+				     (double *)s_out, NULL, 1, rows*cols, flags);
+    break;
+  }
+  wisdom_dirty = 1;
+  if(!inplace)
+    fftw_free(s_out);
+  fftw_free(s_in);
+  return e->plan;
+}
+
+void
+fft_cleanup(void)
+{
+  for(int k = 0; k < plans_size; k++)
+    fftw_destroy_plan(plans[k].plan);
+  free(plans);
+  plans          = NULL;
+  plans_size     = 0;
+  plans_capacity = 0;
+  for(int k = 0; k < 2; k++){
+    fftw_free(work[k]);
+    work[k]      = NULL;
+    work_size[k] = 0;
+  }
+  if(wisdom_dirty && *wisdom_file())
+    fftw_export_wisdom_to_filename(wisdom_file());
+  wisdom_dirty  = 0;
+  wisdom_loaded = 0;
+#ifdef HAVE_FFTW_THREADS
+  if(threaded)
+    fftw_cleanup_threads();
+  else
+#endif
+    fftw_cleanup();
+  threaded     = 0;
+  threads_init = 0;
+  nthreads     = 0;
+}
+
 fftw_complex
 *forward(int rows, int cols, unsigned short* g_img)
 {
-  (void)rows;
-  (void)cols;
-  (void)g_img;
-  return NULL;
-}
+  unsigned int size = rows*cols;
+  fftw_complex *in = malloc(size*sizeof(fftw_complex));
+  fftw_complex *out = malloc(size*sizeof(fftw_complex));  
+  if (in == NULL || out == NULL){
+    fprintf(stderr, "Cannot allocate more memory (in forward)\n");
+    exit(EXIT_FAILURE);
+  }
+  // Initializing the complex image
+  for(unsigned int i = 0; i < size; i++){
+    fftw_complex c = g_img[i] + I*0; 
+    in[i] = c;
+  } 
 
+  fftw_execute_dft(get_plan(rows, cols, C2C_FORWARD, 1, in, out), in, out);
+  free(in);
+  return out;
+}
 
 unsigned short 
 *backward(int rows, int cols, fftw_complex* freq_repr)
 {
-  (void)rows;
-  (void)cols;
-  (void)freq_repr;
-  return NULL;
+  unsigned int size = rows*cols;
+  fftw_complex *out = malloc(size*sizeof(fftw_complex));
+  unsigned short *img = malloc(size*sizeof(unsigned short));
+  if (out == NULL || img == NULL){
+    fprintf(stderr, "Cannot allocate more memory (in backward)\n");
+    exit(EXIT_FAILURE);
+  } 
+
+  fftw_execute_dft(get_plan(rows, cols, C2C_BACKWARD, 1, freq_repr, out),
+		   freq_repr, out);
+
+  for(unsigned int i = 0; i < size; i++){
+    // Set the normalizing value to the gray-scaled image
+    double real = creal(out[i])/(size);
+    if(real <0) img[i]=0;
+    else if (real > 255) img[i] = 255;
+    else img[i] = (unsigned short) (real + 0.5);
+  } 
+
+  free(out);
+  return img;
 }
 
 void
 freq2spectra(int rows, int cols, fftw_complex* freq_repr, float* as, float* ps) 
 {
-  (void)rows;
-  (void)cols;
-  (void)freq_repr;
-  (void)as;
-  (void)ps;
-}
+  unsigned int size = rows*cols;
 
+  for(unsigned int i = 0; i < size; i++){
+    as[i] = cabs(freq_repr[i]);
+    ps[i] = carg(freq_repr[i]); 
+  } 
+}
 
 void 
 spectra2freq(int rows, int cols, float* as, float* ps, fftw_complex* freq_repr)
 {
-  (void)rows;
-  (void)cols;
-  (void)freq_repr;
-  (void)as;
-  (void)ps;
+  unsigned int size = rows*cols;
+
+  for(unsigned int i = 0; i < size; i++){
+    freq_repr[i]= as[i] * cexp(I * ps[i]);
+  }
+}
+
+fftw_complex
+*forward_r2c_many(int rows, int cols, int howmany, unsigned short* planes)
+{
+  unsigned int size = howmany*rows*cols;
+  double *in = get_work(0, size*sizeof(double));
+  fftw_complex *out = malloc(howmany*rows*(cols/2+1)*sizeof(fftw_complex));
+  if (out == NULL){
+    fprintf(stderr, "Cannot allocate more memory (in forward_r2c_many)\n");
+    exit(EXIT_FAILURE);
+  }
+  for(unsigned int i = 0; i < size; i++)
+    in[i] = planes[i];
+
+  fftw_execute_dft_r2c(get_plan(rows, cols, R2C, howmany, in, out), in, out);
+  return out;
+}
+
+fftw_complex
+*forward_r2c(int rows, int cols, unsigned short* g_img)
+{
+  return forward_r2c_many(rows, cols, 1, g_img);
+}
+
+unsigned short
+*backward_c2r_many(int rows, int cols, int howmany, fftw_complex* freq_repr)
+{
+  unsigned int size = howmany*rows*cols;
+  unsigned int half = howmany*rows*(cols/2+1);
+  fftw_complex *tmp = get_work(0, half*sizeof(fftw_complex));
+  double *out = get_work(1, size*sizeof(double));
+  unsigned short *img = malloc(size*sizeof(unsigned short));
+  if (img == NULL){
+    fprintf(stderr, "Cannot allocate more memory (in backward_c2r_many)\n");
+    exit(EXIT_FAILURE);
+  }
+  // A multi-dimensional c2r transform overwrites its input
+  memcpy(tmp, freq_repr, half*sizeof(fftw_complex));
+  fftw_execute_dft_c2r(get_plan(rows, cols, C2R, howmany, tmp, out), tmp, out);
+
+  for(unsigned int i = 0; i < size; i++){
+    double real = out[i]/(rows*cols);
+    if(real <0) img[i]=0;
+    else if (real > 255) img[i] = 255;
+    else img[i] = (unsigned short) (real + 0.5);
+  }
+
+  return img;
+}
+
+unsigned short
+*backward_c2r(int rows, int cols, fftw_complex* freq_repr)
+{
+  return backward_c2r_many(rows, cols, 1, freq_repr);
+}
+
+void
+freq2spectra_half(int rows, int cols, fftw_complex* freq_repr, float* as, float* ps)
+{
+  int hcols = cols/2+1;
+
+  for(int u = 0; u < rows; u++)
+    for(int v = 0; v < hcols; v++){
+      float a = cabs(freq_repr[u*hcols + v]);
+      float p = carg(freq_repr[u*hcols + v]);
+      as[u*cols + v] = a;
+      ps[u*cols + v] = p;
+      // F(-u,-v) is the conjugate of F(u,v)
+      int mu = (rows-u) % rows;
+      int mv = (cols-v) % cols;
+      if(mv >= hcols){
+        as[mu*cols + mv] = a;
+        ps[mu*cols + mv] = -p;
+      }
+    }
+}
+
+void
+spectra2freq_half(int rows, int cols, float* as, float* ps, fftw_complex* freq_repr)
+{
+  int hcols = cols/2+1;
+
+  for(int u = 0; u < rows; u++)
+    for(int v = 0; v < hcols; v++)
+      freq_repr[u*hcols + v] = as[u*cols + v] * cexp(I * ps[u*cols + v]);
+}
+
+void
+apply_gain(int size, int howmany, fftw_complex* freq_repr, const float* gain)
+{
+  // A complex is a pair of doubles, both scaled by the gain of the bin: one
+  // SSE2 multiply per bin, which gcc does not vectorize by itself at -O2
+  double *p = (double *)freq_repr;
+
+  for(int k = 0; k < howmany; k++, p += 2*size)
+#ifdef __SSE2__
+    for(int i = 0; i < size; i++)
+      _mm_storeu_pd(p + 2*i, _mm_mul_pd(_mm_loadu_pd(p + 2*i),
+					 _mm_set1_pd(gain[i])));
+#else
+    for(int i = 0; i < size; i++){
+      p[2*i]   *= gain[i];
+      p[2*i+1] *= gain[i];
+    }
+#endif
+}
+
+void
+apply_gain_fn(int rows, int cols, int howmany, fftw_complex* freq_repr,
+	      float (*gain)(int u, int v, void *param), void *param)
+{
+  int hcols = cols/2+1;
+  float *row = malloc(hcols*sizeof(float));
+  if (row == NULL){
+    fprintf(stderr, "Cannot allocate more memory (in apply_gain_fn)\n");
+    exit(EXIT_FAILURE);
+  }
+
+  // Each row of gains is evaluated once for all the spectra
+  for(int i = 0; i < rows; i++){
+    int u = i <= rows/2 ? i : i - rows;
+    for(int v = 0; v < hcols; v++)
+      row[v] = gain(u, v, param);
+    for(int k = 0; k < howmany; k++)
+      apply_gain(hcols, 1, freq_repr + (k*rows + i)*hcols, row);
+  }
+  free(row);
 }
@@ -53,4 +53,124 @@ freq2spectra(int rows, int cols, fftw_complex *freq_repr, float *as, float *ps);
 extern void 
 spectra2freq(int rows, int cols, float* as, float* ps, fftw_complex* freq_repr);
 
+/**
+ * @brief perform a discrete 2D Fourier transform from a grayscale image with
+ *        a real-to-complex transform, keeping only the half spectrum the
+ *        others are the conjugates of
+ * @param int rows: the input image height
+ * @param int cols: the input image width
+ * @param unsigned short* gray_image: the grayscale input image
+ * @return the rows*(cols/2+1) half spectrum, row major
+ */
+extern fftw_complex 
+*forward_r2c(int rows, int cols, unsigned short *gray_image);
+
+/**
+ * @brief perform a discrete inverse 2D Fourier transform from a half
+ *        spectrum with a complex-to-real transform
+ * @param int rows: the output image height
+ * @param int cols: the output image width
+ * @param fft_complex* freq_repr: the rows*(cols/2+1) half spectrum, kept
+ * @return the grayscale image from inverse Fourier transform
+ */
+extern unsigned short 
+*backward_c2r(int rows, int cols, fftw_complex *freq_repr);
+
+/**
+ * @brief perform the discrete 2D Fourier transforms of several grayscale
+ *        planes, such as the channels of a color image, with a single
+ *        real-to-complex plan
+ * @param int rows: the input planes height
+ * @param int cols: the input planes width
+ * @param int howmany: the number of planes
+ * @param unsigned short* planes: the howmany rows*cols planes, one after
+ *        the other
+ * @return the howmany rows*(cols/2+1) half spectra, one after the other
+ */
+extern fftw_complex
+*forward_r2c_many(int rows, int cols, int howmany, unsigned short *planes);
+
+/**
+ * @brief perform the discrete inverse 2D Fourier transforms of several half
+ *        spectra with a single complex-to-real plan
+ * @param int rows: the output planes height
+ * @param int cols: the output planes width
+ * @param int howmany: the number of planes
+ * @param fft_complex* freq_repr: the howmany rows*(cols/2+1) half spectra,
+ *        one after the other, kept
+ * @return the howmany grayscale planes, one after the other
+ */
+extern unsigned short
+*backward_c2r_many(int rows, int cols, int howmany, fftw_complex *freq_repr);
+
+/**
+ * @brief compute the full amplitude and phase spectrum from a half spectrum,
+ *        the other half being mirrored (same amplitude, opposite phase)
+ * @param int rows: the image height
+ * @param int cols: the image width
+ * @param fft_complex* freq_repr: the rows*(cols/2+1) half spectrum
+ * @param float* as: the rows*cols amplitude spectrum output
+ * @param float* ps: the rows*cols phase spectrum output
+ */
+extern void
+freq2spectra_half(int rows, int cols, fftw_complex *freq_repr, float *as, float *ps);
+
+/**
+ * @brief compute the half spectrum from a full amplitude and phase spectrum,
+ *        only the bins of the half being read
+ * @param int rows: the image height
+ * @param int cols: the image width
+ * @param float* as: the rows*cols amplitude spectrum input
+ * @param float* ps: the rows*cols phase spectrum input
+ * @param fft_complex* freq_repr: the rows*(cols/2+1) half spectrum output
+ */
+extern void
+spectra2freq_half(int rows, int cols, float* as, float* ps, fftw_complex* freq_repr);
+
+/**
+ * @brief multiply the bins of one or several spectra by real gains, in
+ *        place, instead of a round trip through the amplitude and phase
+ *        spectra
+ * @param int size: the number of bins of a spectrum, rows*cols for a full
+ *        one, rows*(cols/2+1) for a half one
+ * @param int howmany: the number of spectra, one after the other
+ * @param fft_complex* freq_repr: the spectra
+ * @param float* gain: the size gains, shared by the spectra
+ */
+extern void
+apply_gain(int size, int howmany, fftw_complex *freq_repr, const float *gain);
+
+/**
+ * @brief multiply the bins of one or several half spectra by the real gains
+ *        of a function of the frequency, in place
+ * @param int rows: the image height
+ * @param int cols: the image width
+ * @param int howmany: the number of rows*(cols/2+1) half spectra, one after
+ *        the other
+ * @param fft_complex* freq_repr: the half spectra
+ * @param gain: the gain of the frequency (u, v), u between -(rows-1)/2 and
+ *        rows/2, v between 0 and cols/2, evaluated once per bin
+ * @param void* param: passed to the gain function
+ */
+extern void
+apply_gain_fn(int rows, int cols, int howmany, fftw_complex *freq_repr,
+	      float (*gain)(int u, int v, void *param), void *param);
+
+/**
+ * @brief set the number of threads of the transforms planned from now on
+ * @param int n: the number of threads, FFT_THREADS or the number of online
+ *        processors when not positive
+ * @return the number of threads used, 1 when FFTW is not threaded
+ */
+extern int
+fft_set_threads(int n);
+
+/**
+ * @brief release the cached plans and save the accumulated wisdom, done
+ *        automatically at exit, the wisdom file being loaded again before
+ *        the next plan
+ */
+extern void
+fft_cleanup(void);
+
 #endif /* FFT_H */
@@ -136,6 +136,80 @@ test_reconstruction(char* name)
   fprintf(stderr, "OK\n");
 }
 
+/**
+ * @brief test the real-to-complex transforms against the complex ones: the
+ *        half spectrum must match the complex spectrum, the mirrored
+ *        amplitude and phase spectrum the full ones, and the inverse
+ *        transform must give back the image
+ * @param char* name, the input image file name
+ */
+void
+test_r2c(char* name)
+{
+  fprintf(stderr, "test_r2c: ");
+
+  pnm img = pnm_load(name);
+  int cols = pnm_get_width(img);
+  int rows = pnm_get_height(img);
+  int size = cols*rows;
+  int hcols = cols/2+1;
+
+  unsigned short *g_img = malloc(rows*cols*sizeof(unsigned short));
+  generate_gray_image(cols, rows, img, g_img);
+  pnm_free(img);
+
+  fftw_complex *comp = forward(rows, cols, g_img);
+  fftw_complex *half = forward_r2c(rows, cols, g_img);
+
+  float* as = malloc(size*sizeof(float));
+  float* ps = malloc(size*sizeof(float));
+  float* has = malloc(size*sizeof(float));
+  float* hps = malloc(size*sizeof(float));
+  freq2spectra(rows, cols, comp, as, ps);
+  freq2spectra_half(rows, cols, half, has, hps);
+
+  double err = 0, amax = 0;
+  for(int u = 0; u < rows; u++)
+    for(int v = 0; v < hcols; v++){
+      double e = cabs(comp[u*cols + v] - half[u*hcols + v]);
+      if(e > err) err = e;
+    }
+  for(int i = 0; i < size; i++){
+    double e = fabs(as[i] - has[i]);
+    if(e > err) err = e;
+    if(as[i] > amax) amax = as[i];
+    // The phase of the null bins is not significant
+    if(as[i] > 1e-3*amax && fabs(sin((ps[i] - hps[i])/2)) > 1e-3)
+      err = INFINITY;
+  }
+
+  spectra2freq_half(rows, cols, has, hps, half);
+  unsigned short *new_g_img = backward_c2r(rows, cols, half);
+  int diff = 0;
+  for(int i = 0; i < size; i++)
+    if(new_g_img[i] != g_img[i])
+      diff++;
+
+  pnm new_image = pnm_new(cols, rows, PnmRawPpm);
+  set_comp(cols, rows, new_g_img, new_image);
+  save_image(name, "FB-R2C-", new_image);
+
+  free(g_img);
+  free(new_g_img);
+  free(comp);
+  free(half);
+  free(as);
+  free(ps);
+  free(has);
+  free(hps);
+  pnm_free(new_image);
+
+  if(err > 1e-6*amax || diff > 0)
+    fprintf(stderr, "FAILED (spectrum error %g, %d pixels differ)\n", err, diff);
+  else
+    fprintf(stderr, "OK\n");
+}
+
 /**
  * @brief Recenter the frequency image, in order to put the low frequencies at the center at the image.
  * @param cols the number of columns of the input image
@@ -299,6 +373,64 @@ test_add_frequencies(char* name)
   fprintf(stderr, "OK\n");
 }
 
+/**
+ * @brief test the batched transforms on the three channels of a color
+ *        image against the per-channel ones, and the reconstruction
+ * @param char* name, the input image file name
+ */
+void
+test_color(char* name)
+{
+  fprintf(stderr, "test_color: ");
+
+  pnm img = pnm_load(name);
+  int cols = pnm_get_width(img);
+  int rows = pnm_get_height(img);
+  int size = cols*rows;
+  int half = rows*(cols/2+1);
+
+  unsigned short *planes = malloc(3*size*sizeof(unsigned short));
+  for(int c = 0; c < 3; c++)
+    for(int i = 0; i < rows; i++)
+      for(int j = 0; j < cols; j++)
+        planes[c*size + i*cols + j] = pnm_get_component(img, i, j, c);
+
+  fftw_complex *comp = forward_r2c_many(rows, cols, 3, planes);
+
+  double err = 0, amax = 0;
+  for(int c = 0; c < 3; c++){
+    fftw_complex *chan = forward_r2c(rows, cols, planes + c*size);
+    for(int k = 0; k < half; k++){
+      double e = cabs(comp[c*half + k] - chan[k]);
+      if(e > err) err = e;
+      if(cabs(chan[k]) > amax) amax = cabs(chan[k]);
+    }
+    free(chan);
+  }
+
+  unsigned short *new_planes = backward_c2r_many(rows, cols, 3, comp);
+  int diff = 0;
+  for(int i = 0; i < 3*size; i++)
+    if(new_planes[i] != planes[i])
+      diff++;
+
+  for(int c = 0; c < 3; c++)
+    for(int i = 0; i < rows; i++)
+      for(int j = 0; j < cols; j++)
+        pnm_set_component(img, i, j, c, new_planes[c*size + i*cols + j]);
+  save_image(name, "FB-RGB-", img);
+
+  free(planes);
+  free(new_planes);
+  free(comp);
+  pnm_free(img);
+
+  if(err > 1e-6*amax || diff > 0)
+    fprintf(stderr, "FAILED (spectrum error %g, %d pixels differ)\n", err, diff);
+  else
+    fprintf(stderr, "OK\n");
+}
+
 void
 run(char* name)
 {
@@ -306,6 +438,8 @@ run(char* name)
   test_reconstruction(name);
   test_display(name);
   test_add_frequencies(name);
+  test_r2c(name);
+  test_color(name);
 }
 
 void 
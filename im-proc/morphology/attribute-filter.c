@@ -0,0 +1,83 @@
+/**
+ * @file  attribute-filter.c
+ * @brief attribute opening (op 0) or closing (op 1) of an image, each
+ *        channel being filtered on its max-tree or min-tree. The trees are
+ *        built once, whatever the number of thresholds: with several of
+ *        them, imd is a prefix and each result is saved to <imd><lambda>.ppm
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <bcl.h>
+#include <maxtree.h>
+
+void
+usage(char* s)
+{
+  fprintf(stderr,"%s <attribute> <op> <ims> <imd> <lambda> [<lambda>...]\n",s);
+  fprintf(stderr,"  attribute: 0 area, 1 height, 2 bounding box\n");
+  fprintf(stderr,"  op: 0 opening, 1 closing\n");
+  exit(EXIT_FAILURE);
+}
+
+/**
+ * @brief  check whether the three channels of an image are equal, in which
+ *         case a single tree is built
+ */
+int
+is_gray(pnm ims)
+{
+  int             n  = pnm_get_width(ims)*pnm_get_height(ims);
+  unsigned short *ps = pnm_get_image(ims);
+
+  for(int p = 0; p < n; p++, ps += 3)
+    if(ps[0] != ps[1] || ps[0] != ps[2])
+      return 0;
+  return 1;
+}
+
+#define PARAM 5
+int
+main(int argc, char* argv[])
+{
+  if(argc < PARAM+1) usage(argv[0]);
+  int attribute = atoi(argv[1]);
+  int dual      = atoi(argv[2]);
+  pnm ims       = pnm_load(argv[3]);
+  int w         = pnm_get_width(ims);
+  int h         = pnm_get_height(ims);
+  int channels  = is_gray(ims) ? 1 : 3;
+  pnm imd       = pnm_new(w, h, PnmRawPpm);
+
+  if(attribute < AREA || attribute > BBOX || dual < 0 || dual > 1)
+    usage(argv[0]);
+
+  maxtree trees[3];
+  for(int c = 0; c < channels; c++)
+    trees[c] = maxtree_new(w, h, pnm_get_image(ims)+c, 3, dual);
+
+  for(int k = PARAM; k < argc; k++){
+    int             lambda = atoi(argv[k]);
+    unsigned short *pd     = pnm_get_image(imd);
+    char            path[1024];
+
+    for(int c = 0; c < channels; c++)
+      maxtree_filter(trees[c], attribute, lambda, pd+c, 3);
+    for(int p = 0; channels == 1 && p < w*h; p++)
+      pd[3*p+1] = pd[3*p+2] = pd[3*p];
+
+    if(argc == PARAM+1)
+      pnm_save(imd, PnmRawPpm, argv[4]);
+    else{
+      snprintf(path, sizeof(path), "%s%d.ppm", argv[4], lambda);
+      pnm_save(imd, PnmRawPpm, path);
+    }
+  }
+
+  for(int c = 0; c < channels; c++)
+    maxtree_free(trees[c]);
+  pnm_free(ims);
+  pnm_free(imd);
+  return EXIT_SUCCESS;
+}
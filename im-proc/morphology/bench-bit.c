@@ -0,0 +1,111 @@
+/**
+ * @file  bench-bit.c
+ * @brief compare the 16-bit dilation and erosion of morphology.c with the
+ *        bit-packed ones of bitplane.c on a binary image, for every
+ *        structuring element shape and several halfsizes
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <morphology.h>
+#include <se.h>
+#include <bitplane.h>
+
+#define NB_SHAPES 9
+
+static const int halfsizes[] = {1, 3, 5, 10};
+
+static const struct
+{
+  char  *name;
+  void (*order)(unsigned short*, unsigned short*);
+  void (*bit)(bitplane, bitplane, pnm);
+} operators[] = {
+  {"dilate", maximum, bitplane_dilate},
+  {"erode",  minimum, bitplane_erode},
+};
+
+double
+elapsed_ms(clock_t start)
+{
+  return 1000.0*(clock()-start)/CLOCKS_PER_SEC;
+}
+
+/**
+ * @brief  check that the thresholded 16-bit result matches the bit result,
+ *         both operators commuting with the threshold
+ */
+int
+same(pnm im16, pnm imb)
+{
+  int             n  = pnm_get_width(im16)*pnm_get_height(im16);
+  unsigned short *p0 = pnm_get_image(im16);
+  unsigned short *p1 = pnm_get_image(imb);
+
+  for(int p = 0; p < n; p++, p0 += 3, p1 += 3)
+    if((*p0 > pnm_maxval/2) != (*p1 > pnm_maxval/2))
+      return 0;
+  return 1;
+}
+
+void
+run(char *name, int loops)
+{
+  pnm ims  = pnm_load(name);
+  int w    = pnm_get_width(ims);
+  int h    = pnm_get_height(ims);
+  pnm im16 = pnm_new(w, h, PnmRawPpm);
+  pnm imb  = pnm_new(w, h, PnmRawPpm);
+
+  printf("%s (%dx%d), %d loops\n", name, w, h, loops);
+  printf("op     shape hs   16-bit(ms)     bit(ms)  speedup check\n");
+  for(unsigned o = 0; o < sizeof(operators)/sizeof(*operators); o++){
+    for(int s = 0; s < NB_SHAPES; s++){
+      for(unsigned k = 0; k < sizeof(halfsizes)/sizeof(*halfsizes); k++){
+	int hs = halfsizes[k];
+
+	clock_t start = clock();
+	for(int l = 0; l < loops; l++)
+	  process(s, hs, ims, im16, operators[o].order);
+	double t16 = elapsed_ms(start)/loops;
+
+	start = clock();
+	for(int l = 0; l < loops; l++){
+	  pnm      shape = se_compile(s, hs, 0)->image;
+	  bitplane bs    = bitplane_pack(ims, PnmRed);
+	  bitplane bd    = bitplane_new(w, h);
+	  operators[o].bit(bs, bd, shape);
+	  bitplane_unpack(bd, imb);
+	  bitplane_free(bs);
+	  bitplane_free(bd);
+	}
+	double tb = elapsed_ms(start)/loops;
+
+	printf("%-6s %5d %2d %12.3f %11.3f %8.1f %s\n", operators[o].name,
+	       s, hs, t16, tb, tb > 0 ? t16/tb : 0.0,
+	       same(im16, imb) ? "ok" : "FAIL");
+      }
+    }
+  }
+  pnm_free(ims);
+  pnm_free(im16);
+  pnm_free(imb);
+}
+
+void
+usage(char* s)
+{
+  fprintf(stderr,"%s <ims> <loops>\n",s);
+  exit(EXIT_FAILURE);
+}
+
+#define PARAM 2
+int
+main(int argc, char* argv[])
+{
+  if(argc != PARAM+1) usage(argv[0]);
+  run(argv[1], atoi(argv[2]));
+  return EXIT_SUCCESS;
+}
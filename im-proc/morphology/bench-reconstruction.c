@@ -0,0 +1,73 @@
+/**
+ * @file  bench-reconstruction.c
+ * @brief compare the hybrid reconstruction by dilation with the iteration
+ *        of elementary geodesic dilations until stability, the marker being
+ *        an opening of the source image
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <morphology.h>
+#include <geodesic.h>
+#include <se.h>
+
+double
+elapsed_ms(clock_t start)
+{
+  return 1000.0*(clock()-start)/CLOCKS_PER_SEC;
+}
+
+void
+run(char *name, int hs, int loops)
+{
+  pnm ims    = pnm_load(name);
+  int w      = pnm_get_width(ims);
+  int h      = pnm_get_height(ims);
+  pnm marker = pnm_new(w, h, PnmRawPpm);
+  pnm imh    = pnm_new(w, h, PnmRawPpm);
+  pnm imn    = pnm_new(w, h, PnmRawPpm);
+  int n      = 0;
+
+  opening(DISK, hs, ims, marker);
+
+  clock_t start = clock();
+  for(int l = 0; l < loops; l++)
+    reconstruction(marker, ims, imh);
+  double th = elapsed_ms(start)/loops;
+
+  start = clock();
+  for(int l = 0; l < loops; l++)
+    n = reconstruction_naive(marker, ims, imn);
+  double tn = elapsed_ms(start)/loops;
+
+  int same = !memcmp(pnm_get_image(imh), pnm_get_image(imn),
+		     3*w*h*sizeof(unsigned short));
+  printf("%s (%dx%d), marker: opening by disk %d, %d loops\n",
+	 name, w, h, hs, loops);
+  printf("hybrid: %.3f ms, naive: %.3f ms (%d iterations), speedup %.1f %s\n",
+	 th, tn, n, th > 0 ? tn/th : 0.0, same ? "ok" : "FAIL");
+
+  pnm_free(ims);
+  pnm_free(marker);
+  pnm_free(imh);
+  pnm_free(imn);
+}
+
+void
+usage(char* s)
+{
+  fprintf(stderr,"%s <ims> <hs> <loops>\n",s);
+  exit(EXIT_FAILURE);
+}
+
+#define PARAM 3
+int
+main(int argc, char* argv[])
+{
+  if(argc != PARAM+1) usage(argv[0]);
+  run(argv[1], atoi(argv[2]), atoi(argv[3]));
+  return EXIT_SUCCESS;
+}
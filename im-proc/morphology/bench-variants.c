@@ -0,0 +1,170 @@
+/**
+ * @file  bench-variants.c
+ * @brief time the dilation of the four process() variants side by side:
+ *        the 16-bit marginal one (morphology.c), the lexicographic and
+ *        reduced color orderings (morphology-lex.c, morphology-mrg.c) and
+ *        the bit-packed binary one (morphology-bit.c), over every shape,
+ *        several halfsizes and the given images.
+ *
+ * Each variant is compiled into its own object with its symbols renamed
+ * by the Makefile (process_std, process_lex, ...), so that all of them
+ * are linked in the same binary. Each variant is checked against a
+ * reference of its own ordering: the marginal one for the bit variant,
+ * which is skipped on non-binary images, and a plain walk over the points
+ * of the element folding the color vectors with the maximum of the variant
+ * for the lexicographic and reduced ones. A variant whose result differs
+ * from its reference is flagged with a '*', and the fastest correct
+ * variant is reported for each case.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <bcl.h>
+#include <bitplane.h>
+#include <se.h>
+
+typedef void (*order)(unsigned short*, unsigned short*);
+typedef void (*engine)(int, int, pnm, pnm, order);
+
+#define DECLARE(v)							\
+  void process_##v(int, int, pnm, pnm, order);				\
+  void maximum_##v(unsigned short*, unsigned short*);			\
+  void minimum_##v(unsigned short*, unsigned short*);
+
+DECLARE(std)
+DECLARE(lex)
+DECLARE(mrg)
+DECLARE(bit)
+
+#define NB_VARIANTS 4
+#define NB_SHAPES   9
+
+static const struct
+{
+  char   *name;
+  engine  process;
+  order   maximum;
+  int     binary;   /* only valid on binary images */
+  int     vector;   /* checked against the vector reference */
+} variants[NB_VARIANTS] = {
+  {"std", process_std, maximum_std, 0, 0},
+  {"lex", process_lex, maximum_lex, 0, 1},
+  {"mrg", process_mrg, maximum_mrg, 0, 1},
+  {"bit", process_bit, maximum_bit, 1, 0},
+};
+
+static const int halfsizes[] = {1, 3, 5};
+
+double
+elapsed_ms(clock_t start)
+{
+  return 1000.0*(clock()-start)/CLOCKS_PER_SEC;
+}
+
+int
+same(pnm a, pnm b)
+{
+  int n = 3*pnm_get_width(a)*pnm_get_height(a);
+  return !memcmp(pnm_get_image(a), pnm_get_image(b), n*sizeof(unsigned short));
+}
+
+/**
+ * @brief dilation for an ordering of the color vectors: the vectors under
+ *        the element are folded into the one of the center with pf, in
+ *        the order of the points of the element
+ */
+void
+reference(int s, int hs, pnm ims, pnm imd, order pf)
+{
+  int             w  = pnm_get_width(ims);
+  int             h  = pnm_get_height(ims);
+  unsigned short *ps = pnm_get_image(ims);
+  unsigned short *pd = pnm_get_image(imd);
+
+  const struct se_compiled *b = se_compile(s, hs, w);
+
+  for(int i = 0; i < h; i++)
+    for(int j = 0; j < w; j++){
+      unsigned short v[3];
+      memcpy(v, &ps[PNM_OFFSET(w, i, j)], sizeof(v));
+      for(int k = 0; k < b->size; k++){
+	int y = i+b->di[k];
+	int x = j+b->dj[k];
+	if(y >= 0 && y < h && x >= 0 && x < w)
+	  (*pf)(&ps[PNM_OFFSET(w, y, x)], v);
+      }
+      memcpy(&pd[PNM_OFFSET(w, i, j)], v, sizeof(v));
+    }
+}
+
+void
+run(char *name, int loops)
+{
+  pnm ims    = pnm_load(name);
+  int w      = pnm_get_width(ims);
+  int h      = pnm_get_height(ims);
+  int binary = bitplane_is_binary(ims);
+  pnm ref    = pnm_new(w, h, PnmRawPpm);
+  pnm vref   = pnm_new(w, h, PnmRawPpm);
+  pnm imd    = pnm_new(w, h, PnmRawPpm);
+
+  for(int s = 0; s < NB_SHAPES; s++){
+    for(unsigned k = 0; k < sizeof(halfsizes)/sizeof(*halfsizes); k++){
+      int    hs      = halfsizes[k];
+      int    fastest = 0;
+      double best    = 0;
+
+      printf("%-24s %5d %2d", name, s, hs);
+      for(int v = 0; v < NB_VARIANTS; v++){
+	if(variants[v].binary && !binary){
+	  printf(" %11s", "-");
+	  continue;
+	}
+	pnm     out   = v == 0 ? ref : imd;
+	clock_t start = clock();
+	for(int l = 0; l < loops; l++)
+	  variants[v].process(s, hs, ims, out, variants[v].maximum);
+	double t  = elapsed_ms(start)/loops;
+	if(variants[v].vector)
+	  reference(s, hs, ims, vref, variants[v].maximum);
+	int ok = v == 0 || same(variants[v].vector ? vref : ref, imd);
+	printf(" %10.3f%c", t, ok ? ' ' : '*');
+	if(ok && (v == 0 || t < best)){
+	  fastest = v;
+	  best    = t;
+	}
+      }
+      printf(" %s\n", variants[fastest].name);
+    }
+  }
+  pnm_free(ims);
+  pnm_free(ref);
+  pnm_free(vref);
+  pnm_free(imd);
+}
+
+void
+usage(char* s)
+{
+  fprintf(stderr,"%s <loops> <ims> [<ims>...]\n",s);
+  exit(EXIT_FAILURE);
+}
+
+#define PARAM 2
+int
+main(int argc, char* argv[])
+{
+  if(argc < PARAM+1) usage(argv[0]);
+  int loops = atoi(argv[1]);
+
+  printf("%-24s %5s %2s", "image", "shape", "hs");
+  for(int v = 0; v < NB_VARIANTS; v++)
+    printf(" %7s(ms)", variants[v].name);
+  printf(" fastest\n");
+  for(int k = PARAM; k < argc; k++)
+    run(argv[k], loops);
+  return EXIT_SUCCESS;
+}
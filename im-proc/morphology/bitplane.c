@@ -0,0 +1,197 @@
+#include <string.h>
+
+#include <bcl.h>
+#include <bitplane.h>
+
+enum {DILATE, ERODE};
+
+bitplane
+bitplane_new(int width, int height)
+{
+  bitplane self = memory_alloc(sizeof(struct bitplane));
+  self->width  = width;
+  self->height = height;
+  self->words  = (width+63)/64;
+  self->bits   = memory_calloc(height*self->words*sizeof(uint64_t));
+  return self;
+}
+
+void
+bitplane_free(bitplane self)
+{
+  memory_free(self->bits);
+  memory_free(self);
+}
+
+int
+bitplane_is_binary(pnm ims)
+{
+  int             n  = pnm_get_width(ims)*pnm_get_height(ims);
+  unsigned short *ps = pnm_get_image(ims);
+
+  for(int p = 0; p < n; p++, ps += 3)
+    if((ps[0] != 0 && ps[0] != pnm_maxval) || ps[1] != ps[0] || ps[2] != ps[0])
+      return 0;
+  return 1;
+}
+
+bitplane
+bitplane_pack(pnm ims, pnmChannel channel)
+{
+  int             w    = pnm_get_width(ims);
+  int             h    = pnm_get_height(ims);
+  unsigned short *ps   = pnm_get_image(ims) + channel;
+  bitplane        self = bitplane_new(w, h);
+
+  for(int i = 0; i < h; i++){
+    uint64_t *row = self->bits + i*self->words;
+    for(int j = 0; j < w; j++, ps += 3)
+      if(*ps > pnm_maxval/2)
+	row[j/64] |= (uint64_t)1 << (j%64);
+  }
+  return self;
+}
+
+void
+bitplane_unpack(bitplane self, pnm imd)
+{
+  unsigned short *pd = pnm_get_image(imd);
+
+  for(int i = 0; i < self->height; i++){
+    uint64_t *row = self->bits + i*self->words;
+    for(int j = 0; j < self->width; j++){
+      unsigned short v = (row[j/64] >> (j%64)) & 1 ? pnm_maxval : 0;
+      *pd++ = v;
+      *pd++ = v;
+      *pd++ = v;
+    }
+  }
+}
+
+/**
+ * @brief  read the word q of a row, words outside the row and bits past its
+ *         width being replaced by the fill value
+ */
+static uint64_t
+L_word(const uint64_t *row, int words, uint64_t tail, int q, uint64_t fill)
+{
+  if(q < 0 || q >= words)
+    return fill;
+  if(q == words-1)
+    return (row[q] & tail) | (fill & ~tail);
+  return row[q];
+}
+
+/**
+ * @brief  read the 64 pixels of a row starting at the (possibly negative)
+ *         position pos
+ */
+static uint64_t
+L_read(const uint64_t *row, int words, uint64_t tail, int pos, uint64_t fill)
+{
+  int q = pos >= 0 ? pos/64 : -((63-pos)/64);
+  int r = pos - 64*q;
+
+  if(q >= 0 && q+1 < words-1)
+    return r == 0 ? row[q] : (row[q] >> r) | (row[q+1] << (64-r));
+  uint64_t lo = L_word(row, words, tail, q, fill);
+  if(r == 0)
+    return lo;
+  return (lo >> r) | (L_word(row, words, tail, q+1, fill) << (64-r));
+}
+
+/**
+ * @brief  dilation or erosion of a bit plane. Each row of the structuring
+ *         element is first applied horizontally, once per distinct row
+ *         pattern, then the shifted partial results are merged vertically
+ */
+static void
+L_apply(bitplane ims, bitplane imd, pnm shape, int op)
+{
+  int       size   = pnm_get_width(shape);
+  int       hs     = size/2;
+  int       w      = ims->width;
+  int       h      = ims->height;
+  int       words  = ims->words;
+  uint64_t  fill   = op == DILATE ? 0 : ~(uint64_t)0;
+  uint64_t  tail   = w%64 ? ((uint64_t)1 << (w%64)) - 1 : ~(uint64_t)0;
+  int      *dx     = memory_alloc(size*sizeof(int));
+  int      *kind   = memory_alloc(size*sizeof(int));
+  int       nkinds = 0;
+  uint64_t *rows   = memory_alloc(size*h*words*sizeof(uint64_t));
+
+  for(int r = 0; r < size; r++){
+    // Rows with the same pattern share their horizontal pass
+    kind[r] = -1;
+    for(int q = 0; q < r && kind[r] < 0; q++){
+      if(kind[q] < 0)
+	continue;
+      int same = 1;
+      for(int j = 0; j < size && same; j++)
+	same = pnm_get_component(shape, q, j, PnmRed) ==
+	       pnm_get_component(shape, r, j, PnmRed);
+      if(same)
+	kind[r] = kind[q];
+    }
+    if(kind[r] >= 0)
+      continue;
+
+    int n = 0;
+    for(int j = 0; j < size; j++)
+      if(pnm_get_component(shape, r, j, PnmRed) == 255)
+	dx[n++] = j-hs;
+    if(n == 0)
+      continue;
+
+    kind[r] = nkinds;
+    uint64_t *pd = rows + nkinds*h*words;
+    for(int i = 0; i < h; i++){
+      const uint64_t *row = ims->bits + i*words;
+      for(int k = 0; k < words; k++){
+	uint64_t acc = L_read(row, words, tail, 64*k+dx[0], fill);
+	for(int t = 1; t < n; t++)
+	  if(op == DILATE)
+	    acc |= L_read(row, words, tail, 64*k+dx[t], fill);
+	  else
+	    acc &= L_read(row, words, tail, 64*k+dx[t], fill);
+	*pd++ = acc;
+      }
+    }
+    nkinds++;
+  }
+
+  for(int i = 0; i < h; i++){
+    uint64_t *pd = imd->bits + i*words;
+    for(int k = 0; k < words; k++)
+      pd[k] = fill;
+    for(int r = 0; r < size; r++){
+      int y = i+r-hs;
+      if(kind[r] < 0 || y < 0 || y >= h)
+	continue;
+      const uint64_t *ps = rows + (kind[r]*h + y)*words;
+      if(op == DILATE)
+	for(int k = 0; k < words; k++)
+	  pd[k] |= ps[k];
+      else
+	for(int k = 0; k < words; k++)
+	  pd[k] &= ps[k];
+    }
+    pd[words-1] &= tail;
+  }
+
+  memory_free(dx);
+  memory_free(kind);
+  memory_free(rows);
+}
+
+void
+bitplane_dilate(bitplane ims, bitplane imd, pnm shape)
+{
+  L_apply(ims, imd, shape, DILATE);
+}
+
+void
+bitplane_erode(bitplane ims, bitplane imd, pnm shape)
+{
+  L_apply(ims, imd, shape, ERODE);
+}
@@ -0,0 +1,87 @@
+#ifndef __BITPLANE_HH__
+#define __BITPLANE_HH__
+
+/**
+ *  @file  bitplane.h
+ *  @brief header for bitplane.c that implements a bit-packed representation
+ *         of binary images and the binary dilation and erosion working on it.
+ *         Each row is packed into 64-bit words, pixel x of a row being the
+ *         bit x%64 of the word x/64, so that a single word operation
+ *         processes 64 pixels at once.
+ */
+#include <stdint.h>
+#include <pnm.h>
+
+typedef struct bitplane *bitplane;
+
+struct bitplane
+{
+  int       width;
+  int       height;
+  int       words;  /* number of 64-bit words per row */
+  uint64_t *bits;
+};
+
+/**
+ * @brief  allocate a cleared bit plane
+ * @param  width: the plane width in pixels
+ * @param  height: the plane height in pixels
+ * @return the new bit plane
+ */
+bitplane
+bitplane_new(int width, int height);
+
+/**
+ * @brief  release a bit plane
+ * @param  self: the bit plane to free
+ */
+void
+bitplane_free(bitplane self);
+
+/**
+ * @brief  check whether an image is binary, its three channels being equal
+ *         and its values 0 or pnm_maxval
+ * @param  ims: the input image
+ * @return 1 if the image is binary, 0 otherwise
+ */
+int
+bitplane_is_binary(pnm ims);
+
+/**
+ * @brief  pack one channel of a pnm image into a new bit plane, a pixel
+ *         being set when its value is greater than pnm_maxval/2
+ * @param  ims: the input image
+ * @param  channel: the channel to pack
+ * @return the new bit plane
+ */
+bitplane
+bitplane_pack(pnm ims, pnmChannel channel);
+
+/**
+ * @brief  unpack a bit plane into the three channels of a pnm image,
+ *         writing pnm_maxval for set pixels and 0 otherwise
+ * @param  self: the bit plane to unpack
+ * @param  imd: the destination image, of the same size as the plane
+ */
+void
+bitplane_unpack(bitplane self, pnm imd);
+
+/**
+ * @brief  compute the binary dilation of a bit plane by a structuring element
+ * @param  ims: the source plane
+ * @param  imd: the destination plane, of the same size as ims
+ * @param  shape: the structuring element as a pnm binary image
+ */
+void
+bitplane_dilate(bitplane ims, bitplane imd, pnm shape);
+
+/**
+ * @brief  compute the binary erosion of a bit plane by a structuring element
+ * @param  ims: the source plane
+ * @param  imd: the destination plane, of the same size as ims
+ * @param  shape: the structuring element as a pnm binary image
+ */
+void
+bitplane_erode(bitplane ims, bitplane imd, pnm shape);
+
+#endif
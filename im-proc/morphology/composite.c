@@ -0,0 +1,168 @@
+#include <morphology.h>
+#include <se.h>
+
+/*
+ * Operators composed of erosions and dilations. The two steps of an opening
+ * or a closing ping-pong between a single scratch image and the destination,
+ * so a top-hat only allocates one intermediate image whatever its number of
+ * steps.
+ */
+
+/**
+ * @brief  apply pf1 then pf2, the intermediate result going to tmp
+ */
+static void
+L_chain(int s, int hs, pnm ims, pnm tmp, pnm imd,
+	void (*pf1)(unsigned short*, unsigned short*),
+	void (*pf2)(unsigned short*, unsigned short*))
+{
+  process(s, hs, ims, tmp, pf1);
+  process(s, hs, tmp, imd, pf2);
+}
+
+/**
+ * @brief  in place difference imd = a - b, negative values being clamped
+ */
+static void
+L_difference(pnm a, pnm b, pnm imd)
+{
+  int             n  = 3*pnm_get_width(a)*pnm_get_height(a);
+  unsigned short *pa = pnm_get_image(a);
+  unsigned short *pb = pnm_get_image(b);
+  unsigned short *pd = pnm_get_image(imd);
+
+  for(int p = 0; p < n; p++)
+    pd[p] = pa[p] > pb[p] ? pa[p]-pb[p] : 0;
+}
+
+void
+opening(int s, int hs, pnm ims, pnm imd)
+{
+  pnm tmp = pnm_new(pnm_get_width(ims), pnm_get_height(ims), PnmRawPpm);
+  L_chain(s, hs, ims, tmp, imd, minimum, maximum);
+  pnm_free(tmp);
+}
+
+void
+closing(int s, int hs, pnm ims, pnm imd)
+{
+  pnm tmp = pnm_new(pnm_get_width(ims), pnm_get_height(ims), PnmRawPpm);
+  L_chain(s, hs, ims, tmp, imd, maximum, minimum);
+  pnm_free(tmp);
+}
+
+void
+white_top_hat(int s, int hs, pnm ims, pnm imd)
+{
+  pnm tmp = pnm_new(pnm_get_width(ims), pnm_get_height(ims), PnmRawPpm);
+  L_chain(s, hs, ims, tmp, imd, minimum, maximum);
+  L_difference(ims, imd, imd);
+  pnm_free(tmp);
+}
+
+void
+black_top_hat(int s, int hs, pnm ims, pnm imd)
+{
+  pnm tmp = pnm_new(pnm_get_width(ims), pnm_get_height(ims), PnmRawPpm);
+  L_chain(s, hs, ims, tmp, imd, maximum, minimum);
+  L_difference(imd, ims, imd);
+  pnm_free(tmp);
+}
+
+void
+gradient(int s, int hs, pnm ims, pnm imd)
+{
+  int             w    = pnm_get_width(ims);
+  int             h    = pnm_get_height(ims);
+  unsigned short *ps   = pnm_get_image(ims);
+  unsigned short *pd   = pnm_get_image(imd);
+
+  const struct se_compiled *b   = se_compile(s, hs, w);
+  const int                *di  = b->di;
+  const int                *dj  = b->dj;
+  const int                *off = b->offsets;
+  int                       n   = b->size;
+
+  for(int i = 0; i < h; i++){
+    int inner = i >= hs && i < h-hs;
+    for(int j = 0; j < w; j++){
+      for(int c = 0; c < 3; c++){
+	int            p   = PNM_OFFSET(w, i, j)+c;
+	unsigned short max = ps[p];
+	unsigned short min = ps[p];
+	if(inner && j >= hs && j < w-hs){
+	  for(int k = 0; k < n; k++){
+	    unsigned short v = ps[p+off[k]];
+	    if(v > max) max = v;
+	    if(v < min) min = v;
+	  }
+	}else{
+	  for(int k = 0; k < n; k++){
+	    int y = i+di[k];
+	    int x = j+dj[k];
+	    if(y < 0 || y >= h || x < 0 || x >= w)
+	      continue;
+	    unsigned short v = ps[PNM_OFFSET(w, y, x)+c];
+	    if(v > max) max = v;
+	    if(v < min) min = v;
+	  }
+	}
+	pd[p] = max-min;
+      }
+    }
+  }
+}
+
+static double
+L_volume(pnm ims)
+{
+  int             n  = 3*pnm_get_width(ims)*pnm_get_height(ims);
+  unsigned short *ps = pnm_get_image(ims);
+  double          v  = 0;
+
+  for(int p = 0; p < n; p++)
+    v += ps[p];
+  return v;
+}
+
+void
+granulometry(int s, int n, pnm ims, double *volumes)
+{
+  int w = pnm_get_width(ims);
+  int h = pnm_get_height(ims);
+  pnm a = pnm_new(w, h, PnmRawPpm);
+
+  volumes[0] = L_volume(ims);
+  if(!se_compile(s, 1, w)->decomposable){
+    for(int hs = 1; hs <= n; hs++){
+      opening(s, hs, ims, a);
+      volumes[hs] = L_volume(a);
+    }
+    pnm_free(a);
+    return;
+  }
+
+  // The erosion by hs is the erosion by 1 of the erosion by hs-1, pixels
+  // outside the image being ignored at both steps, and the opening is
+  // completed by hs dilations by 1 of it
+  pnm ero = pnm_dup(ims);
+  pnm b   = pnm_new(w, h, PnmRawPpm);
+  pnm t;
+  for(int hs = 1; hs <= n; hs++){
+    process(s, 1, ero, a, minimum);
+    t   = ero;
+    ero = a;
+    a   = t;
+    process(s, 1, ero, a, maximum);
+    for(int k = 1; k < hs; k++){
+      process(s, 1, a, b, maximum);
+      t = a;
+      a = b;
+      b = t;
+    }
+    volumes[hs] = L_volume(a);
+  }
+  pnm_free(ero);
+  pnm_free(a);
+  pnm_free(b);
+}
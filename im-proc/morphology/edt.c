@@ -0,0 +1,222 @@
+/**
+ * @file  edt.c
+ * @brief exact squared Euclidean distance transform (Meijster et al.)
+ *
+ * The first pass computes, for each column, the distance to the nearest
+ * pixel of the set in that column with a forward and a backward scan. The
+ * columns are shared between the workers and scanned row by row, so that
+ * the memory is read in order. The second pass computes, for each row, the
+ * lower envelope of the parabolas (x-i)^2 + g(i)^2 of the first pass and
+ * samples it, the rows being shared between the workers.
+ */
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <limits.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include <bcl.h>
+#include <edt.h>
+
+struct job
+{
+  int                  w;
+  int                  h;
+  int                  threads;
+  const unsigned char *set;
+  int                 *dist;
+  pthread_barrier_t    barrier;
+};
+
+struct worker
+{
+  struct job *job;
+  int         rank;
+};
+
+static long long
+L_f(int x, int i, const int *g)
+{
+  return (long long)(x-i)*(x-i) + (long long)g[i]*g[i];
+}
+
+static long long
+L_sep(int i, int u, const int *g)
+{
+  return ((long long)u*u - (long long)i*i
+	  + (long long)g[u]*g[u] - (long long)g[i]*g[i]) / (2*(u-i));
+}
+
+/**
+ * @brief  distance of each pixel of columns [x0, x1) to the nearest pixel of
+ *         the set in the same column, w+h when there is none
+ */
+static void
+L_columns(struct job *job, int x0, int x1)
+{
+  int                  w   = job->w;
+  int                  h   = job->h;
+  const unsigned char *set = job->set;
+  int                 *g   = job->dist;
+
+  for(int x = x0; x < x1; x++)
+    g[x] = set[x] ? 0 : w+h;
+  for(int y = 1; y < h; y++)
+    for(int x = x0; x < x1; x++)
+      g[y*w+x] = set[y*w+x] ? 0 : g[(y-1)*w+x]+1;
+  for(int y = h-2; y >= 0; y--)
+    for(int x = x0; x < x1; x++)
+      if(g[(y+1)*w+x] < g[y*w+x])
+	g[y*w+x] = g[(y+1)*w+x]+1;
+}
+
+/**
+ * @brief  squared distances of the rows [y0, y1) from the column distances
+ */
+static void
+L_rows(struct job *job, int y0, int y1)
+{
+  int        w   = job->w;
+  long long  inf = (long long)(w+job->h)*(w+job->h);
+  int       *g   = memory_alloc(w*sizeof(int));
+  int       *s   = memory_alloc(w*sizeof(int));
+  int       *t   = memory_alloc(w*sizeof(int));
+
+  for(int y = y0; y < y1; y++){
+    int *d = job->dist+y*w;
+    int  q = 0;
+    for(int x = 0; x < w; x++)
+      g[x] = d[x];
+    s[0] = 0;
+    t[0] = 0;
+    for(int u = 1; u < w; u++){
+      while(q >= 0 && L_f(t[q], s[q], g) > L_f(t[q], u, g))
+	q--;
+      if(q < 0){
+	q    = 0;
+	s[0] = u;
+      }else{
+	long long x = 1 + L_sep(s[q], u, g);
+	if(x < w){
+	  q++;
+	  s[q] = u;
+	  t[q] = x;
+	}
+      }
+    }
+    for(int u = w-1; u >= 0; u--){
+      long long v = L_f(u, s[q], g);
+      d[u] = v < inf ? v : INT_MAX;
+      if(u == t[q])
+	q--;
+    }
+  }
+  memory_free(g);
+  memory_free(s);
+  memory_free(t);
+}
+
+static void *
+work(void *arg)
+{
+  struct worker *self = arg;
+  struct job    *job  = self->job;
+  int            k    = self->rank;
+  int            n    = job->threads;
+
+  L_columns(job, k*job->w/n, (k+1)*job->w/n);
+  pthread_barrier_wait(&job->barrier);
+  L_rows(job, k*job->h/n, (k+1)*job->h/n);
+  return NULL;
+}
+
+/**
+ * @brief number of worker threads, from EDT_THREADS or the number of
+ *        online processors
+ */
+static int
+L_threads(void)
+{
+  char *env = getenv("EDT_THREADS");
+  int   n   = env != NULL ? atoi(env) : (int)sysconf(_SC_NPROCESSORS_ONLN);
+  return n > 0 ? n : 1;
+}
+
+void
+edt(int w, int h, const unsigned char *set, int *dist, int threads)
+{
+  struct job job;
+
+  if(threads <= 0)
+    threads = L_threads();
+  if(threads > w)
+    threads = w;
+  if(threads > h)
+    threads = h;
+  if(threads < 1)
+    return;
+
+  job.w       = w;
+  job.h       = h;
+  job.threads = threads;
+  job.set     = set;
+  job.dist    = dist;
+  pthread_barrier_init(&job.barrier, NULL, threads);
+
+  pthread_t     *tids    = memory_alloc(threads*sizeof(pthread_t));
+  struct worker *workers = memory_alloc(threads*sizeof(struct worker));
+  for(int k = 0; k < threads; k++){
+    workers[k].job  = &job;
+    workers[k].rank = k;
+    if(k > 0)
+      pthread_create(&tids[k], NULL, work, &workers[k]);
+  }
+  work(&workers[0]);
+  for(int k = 1; k < threads; k++)
+    pthread_join(tids[k], NULL);
+
+  pthread_barrier_destroy(&job.barrier);
+  memory_free(tids);
+  memory_free(workers);
+}
+
+/**
+ * @brief  threshold the squared distance to the foreground (op = 0) or to
+ *         the background (op = 1) against the squared disk radius, pixels
+ *         outside the image being ignored as in build_disk
+ */
+static void
+L_disk(pnm ims, pnm imd, int hs, int op)
+{
+  int             w    = pnm_get_width(ims);
+  int             h    = pnm_get_height(ims);
+  unsigned short *ps   = pnm_get_image(ims);
+  unsigned short *pd   = pnm_get_image(imd);
+  unsigned char  *set  = memory_alloc(w*h);
+  int            *dist = memory_alloc(w*h*sizeof(int));
+  long long       r2   = (long long)hs*hs;
+
+  for(int p = 0; p < w*h; p++)
+    set[p] = (ps[3*p] > pnm_maxval/2) != op;
+  edt(w, h, set, dist, 0);
+  for(int p = 0; p < w*h; p++){
+    int in = op == 0 ? dist[p] <= r2 : dist[p] > r2;
+    pd[3*p] = pd[3*p+1] = pd[3*p+2] = in ? pnm_maxval : 0;
+  }
+  memory_free(set);
+  memory_free(dist);
+}
+
+void
+edt_dilate(pnm ims, pnm imd, int halfsize)
+{
+  L_disk(ims, imd, halfsize, 0);
+}
+
+void
+edt_erode(pnm ims, pnm imd, int halfsize)
+{
+  L_disk(ims, imd, halfsize, 1);
+}
@@ -0,0 +1,47 @@
+#ifndef __EDT_HH__
+#define __EDT_HH__
+
+/**
+ *  @file  edt.h
+ *  @brief header for edt.c that implements the exact Euclidean distance
+ *         transform of binary images in linear time (Meijster et al.), and
+ *         the dilation and erosion by a disk derived from it. The transform
+ *         is separable: a first pass on the columns and a second one on the
+ *         rows, each of them shared between worker threads.
+ */
+#include <pnm.h>
+
+/**
+ * @brief  compute the squared Euclidean distance from each pixel to the
+ *         nearest pixel of a set
+ * @param  w: the image width
+ * @param  h: the image height
+ * @param  set: non-zero for the pixels of the set
+ * @param  dist: the squared distances output, INT_MAX when the set is empty
+ * @param  threads: the number of worker threads, the number of online
+ *         processors when not positive
+ */
+void
+edt(int w, int h, const unsigned char *set, int *dist, int threads);
+
+/**
+ * @brief  dilation of a binary image by a disk, i.e. the pixels at a
+ *         distance of at most halfsize from the foreground
+ * @param  ims: the binary input image
+ * @param  imd: the destination image
+ * @param  halfsize: the disk radius
+ */
+void
+edt_dilate(pnm ims, pnm imd, int halfsize);
+
+/**
+ * @brief  erosion of a binary image by a disk, i.e. the pixels at a
+ *         distance greater than halfsize from the background
+ * @param  ims: the binary input image
+ * @param  imd: the destination image
+ * @param  halfsize: the disk radius
+ */
+void
+edt_erode(pnm ims, pnm imd, int halfsize);
+
+#endif
@@ -0,0 +1,43 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <morphology.h>
+#include <se.h>
+#include <bitplane.h>
+#include <rle.h>
+#include <edt.h>
+
+void
+usage(char* s)
+{
+  fprintf(stderr,"%s <se> <hs> <ims> <imd>\n",s);
+  exit(EXIT_FAILURE);
+}
+
+#define PARAM 4
+int
+main(int argc, char* argv[])
+{
+  if(argc != PARAM+1) usage(argv[0]);
+  pnm ims = pnm_load(argv[3]);
+  pnm imd = pnm_new(pnm_get_width(ims), pnm_get_height(ims), PnmRawPpm);
+  int s   = atoi(argv[1]);
+  int hs  = atoi(argv[2]);
+  // Binary images are processed on their runs for line structuring elements
+  if((s == LINE_H || s == LINE_V) && bitplane_is_binary(ims)){
+    rle rs = rle_encode(ims, PnmRed);
+    rle rd = s == LINE_H ? rle_erode_h(rs, hs) : rle_erode_v(rs, hs);
+    rle_decode(rd, imd);
+    rle_free(rs);
+    rle_free(rd);
+  }
+  // and thresholded distances for disks
+  else if(s == DISK && bitplane_is_binary(ims))
+    edt_erode(ims, imd, hs);
+  else
+    process(s, hs, ims, imd, minimum);
+  pnm_save(imd, PnmRawPpm, argv[4]);
+  pnm_free(ims);
+  pnm_free(imd);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,78 @@
+#include <bcl.h>
+#include <flooding.h>
+
+#define LEVELS 256
+
+/*
+ * The hierarchical queue chains the pixels of each bucket through next[],
+ * every pixel being queued at most once. A pixel below the level being
+ * flooded goes to the current bucket, so the current level never goes
+ * back and the flooding runs in O(n + LEVELS).
+ */
+struct queue
+{
+  int  head[LEVELS];
+  int  tail[LEVELS];
+  int *next;
+};
+
+static void
+L_push(struct queue *q, int level, int p)
+{
+  q->next[p] = -1;
+  if(q->head[level] < 0)
+    q->head[level] = p;
+  else
+    q->next[q->tail[level]] = p;
+  q->tail[level] = p;
+}
+
+static int
+L_pop(struct queue *q, int level)
+{
+  int p = q->head[level];
+  q->head[level] = q->next[p];
+  return p;
+}
+
+int
+watershed(int w, int h, const unsigned char *levels, int *labels)
+{
+  struct queue   q;
+  unsigned char *queued  = memory_calloc(w*h);
+  int            flooded = 0;
+
+  q.next = memory_alloc(w*h*sizeof(int));
+  for(int l = 0; l < LEVELS; l++)
+    q.head[l] = -1;
+  for(int p = 0; p < w*h; p++)
+    if(labels[p] != 0){
+      L_push(&q, levels[p], p);
+      queued[p] = 1;
+    }
+
+  for(int level = 0; level < LEVELS; level++){
+    while(q.head[level] >= 0){
+      int p = L_pop(&q, level);
+      int i = p/w;
+      int j = p%w;
+      for(int di = -1; di <= 1; di++)
+	for(int dj = -1; dj <= 1; dj++){
+	  int y = i+di;
+	  int x = j+dj;
+	  if(y < 0 || y >= h || x < 0 || x >= w)
+	    continue;
+	  int n = y*w+x;
+	  if(queued[n])
+	    continue;
+	  labels[n] = labels[p];
+	  queued[n] = 1;
+	  flooded++;
+	  L_push(&q, levels[n] > level ? levels[n] : level, n);
+	}
+    }
+  }
+  memory_free(queued);
+  memory_free(q.next);
+  return flooded;
+}
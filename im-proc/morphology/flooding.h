@@ -0,0 +1,26 @@
+#ifndef __FLOODING_HH__
+#define __FLOODING_HH__
+
+/**
+ *  @file  flooding.h
+ *  @brief header for flooding.c that implements the watershed segmentation
+ *         by flooding from markers (F. Meyer), with the 8-connectivity
+ */
+
+/**
+ * @brief  flood an 8-bit image from labeled markers. The pixels are
+ *         processed by increasing level, and in the FIFO order within a
+ *         level, through a hierarchical queue of 256 buckets, each pixel
+ *         taking the label of the neighbour that reached it first. Pixels
+ *         that no marker can reach keep the label 0.
+ * @param  w: the image width
+ * @param  h: the image height
+ * @param  levels: the image to flood, usually a gradient
+ * @param  labels: the marker labels on input, 0 outside the markers, and
+ *         the label of the catchment basin of each pixel on output
+ * @return the number of pixels flooded
+ */
+int
+watershed(int w, int h, const unsigned char *levels, int *labels);
+
+#endif
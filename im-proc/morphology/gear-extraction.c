@@ -0,0 +1,57 @@
+/**
+ * @file  gear-extraction.c
+ * @brief extract the gear from a noisy binary image: the image is
+ *        thresholded, the noise is removed by an opening, the gear teeth are restored by reconstruction under
+ *        the source image and the holes are filled
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <morphology.h>
+#include <geodesic.h>
+#include <se.h>
+
+void
+usage(char* s)
+{
+  fprintf(stderr,"%s <hs> <ims> <imd>\n",s);
+  exit(EXIT_FAILURE);
+}
+
+/**
+ * @brief  binarize an image in place, values greater than pnm_maxval/2
+ *         becoming pnm_maxval and the others 0
+ */
+void
+threshold(pnm ims)
+{
+  int             n  = 3*pnm_get_width(ims)*pnm_get_height(ims);
+  unsigned short *ps = pnm_get_image(ims);
+
+  for(int p = 0; p < n; p++)
+    ps[p] = ps[p] > pnm_maxval/2 ? pnm_maxval : 0;
+}
+
+#define PARAM 3
+int
+main(int argc, char* argv[])
+{
+  if(argc != PARAM+1) usage(argv[0]);
+  pnm ims    = pnm_load(argv[2]);
+  int w      = pnm_get_width(ims);
+  int h      = pnm_get_height(ims);
+  pnm marker = pnm_new(w, h, PnmRawPpm);
+  pnm imd    = pnm_new(w, h, PnmRawPpm);
+
+  threshold(ims);
+  opening(DISK, atoi(argv[1]), ims, marker);
+  reconstruction(marker, ims, marker);
+  fill_holes(marker, imd);
+  pnm_save(imd, PnmRawPpm, argv[3]);
+
+  pnm_free(ims);
+  pnm_free(marker);
+  pnm_free(imd);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,239 @@
+#include <string.h>
+
+#include <bcl.h>
+#include <geodesic.h>
+
+/*
+ * 8-neighbourhood, the four first neighbours preceding the pixel in the
+ * raster order and the four last ones following it.
+ */
+static const int L_di[8] = {-1, -1, -1,  0, 0,  1, 1, 1};
+static const int L_dj[8] = {-1,  0,  1, -1, 1, -1, 0, 1};
+
+struct fifo
+{
+  int *items;
+  int  capacity;
+  int  head;
+  int  size;
+};
+
+static void
+L_push(struct fifo *f, int p)
+{
+  if(f->size == f->capacity){
+    int *items = memory_alloc(2*f->capacity*sizeof(int));
+    for(int k = 0; k < f->size; k++)
+      items[k] = f->items[(f->head+k) % f->capacity];
+    memory_free(f->items);
+    f->items     = items;
+    f->capacity *= 2;
+    f->head      = 0;
+  }
+  f->items[(f->head+f->size) % f->capacity] = p;
+  f->size++;
+}
+
+static int
+L_pop(struct fifo *f)
+{
+  int p = f->items[f->head];
+  f->head = (f->head+1) % f->capacity;
+  f->size--;
+  return p;
+}
+
+static unsigned short
+L_min(unsigned short a, unsigned short b)
+{
+  return a < b ? a : b;
+}
+
+/**
+ * @brief  hybrid reconstruction by dilation of J under I, in place in J
+ */
+static void
+L_reconstruct(int w, int h, unsigned short *J, const unsigned short *I)
+{
+  struct fifo f = {memory_alloc(w*sizeof(int)), w, 0, 0};
+
+  for(int p = 0; p < w*h; p++)
+    J[p] = L_min(J[p], I[p]);
+
+  // Raster scan: propagate from the preceding neighbours
+  for(int i = 0, p = 0; i < h; i++){
+    for(int j = 0; j < w; j++, p++){
+      unsigned short m = J[p];
+      for(int k = 0; k < 4; k++){
+	int y = i+L_di[k];
+	int x = j+L_dj[k];
+	if(y >= 0 && x >= 0 && x < w && J[y*w+x] > m)
+	  m = J[y*w+x];
+      }
+      J[p] = L_min(m, I[p]);
+    }
+  }
+
+  // Anti-raster scan: propagate from the following neighbours and queue
+  // the pixels that can still propagate further
+  for(int i = h-1, p = w*h-1; i >= 0; i--){
+    for(int j = w-1; j >= 0; j--, p--){
+      unsigned short m = J[p];
+      for(int k = 4; k < 8; k++){
+	int y = i+L_di[k];
+	int x = j+L_dj[k];
+	if(y < h && x >= 0 && x < w && J[y*w+x] > m)
+	  m = J[y*w+x];
+      }
+      J[p] = L_min(m, I[p]);
+      for(int k = 4; k < 8; k++){
+	int y = i+L_di[k];
+	int x = j+L_dj[k];
+	int q = y*w+x;
+	if(y < h && x >= 0 && x < w && J[q] < J[p] && J[q] < I[q]){
+	  L_push(&f, p);
+	  break;
+	}
+      }
+    }
+  }
+
+  // Propagation
+  while(f.size > 0){
+    int p = L_pop(&f);
+    int i = p/w;
+    int j = p%w;
+    for(int k = 0; k < 8; k++){
+      int y = i+L_di[k];
+      int x = j+L_dj[k];
+      int q = y*w+x;
+      if(y < 0 || y >= h || x < 0 || x >= w)
+	continue;
+      if(J[q] < J[p] && I[q] != J[q]){
+	J[q] = L_min(J[p], I[q]);
+	L_push(&f, q);
+      }
+    }
+  }
+  memory_free(f.items);
+}
+
+/**
+ * @brief  reconstruction by iterated elementary geodesic dilations
+ */
+static int
+L_reconstruct_naive(int w, int h, unsigned short *J, const unsigned short *I)
+{
+  unsigned short *tmp = memory_alloc(w*h*sizeof(unsigned short));
+  int             n   = 0;
+  int             changed;
+
+  for(int p = 0; p < w*h; p++)
+    J[p] = L_min(J[p], I[p]);
+
+  do{
+    changed = 0;
+    for(int i = 0, p = 0; i < h; i++){
+      for(int j = 0; j < w; j++, p++){
+	unsigned short m = J[p];
+	for(int k = 0; k < 8; k++){
+	  int y = i+L_di[k];
+	  int x = j+L_dj[k];
+	  if(y >= 0 && y < h && x >= 0 && x < w && J[y*w+x] > m)
+	    m = J[y*w+x];
+	}
+	tmp[p] = L_min(m, I[p]);
+	changed |= tmp[p] != J[p];
+      }
+    }
+    memcpy(J, tmp, w*h*sizeof(unsigned short));
+    n++;
+  }while(changed);
+
+  memory_free(tmp);
+  return n;
+}
+
+void
+reconstruction(pnm marker, pnm mask, pnm imd)
+{
+  int w = pnm_get_width(mask);
+  int h = pnm_get_height(mask);
+
+  for(int c = 0; c < 3; c++){
+    unsigned short *J = pnm_get_channel(marker, NULL, c);
+    unsigned short *I = pnm_get_channel(mask, NULL, c);
+    L_reconstruct(w, h, J, I);
+    pnm_set_channel(imd, J, c);
+    memory_free(J);
+    memory_free(I);
+  }
+}
+
+int
+reconstruction_naive(pnm marker, pnm mask, pnm imd)
+{
+  int w = pnm_get_width(mask);
+  int h = pnm_get_height(mask);
+  int n = 0;
+
+  for(int c = 0; c < 3; c++){
+    unsigned short *J = pnm_get_channel(marker, NULL, c);
+    unsigned short *I = pnm_get_channel(mask, NULL, c);
+    int             k = L_reconstruct_naive(w, h, J, I);
+    if(k > n)
+      n = k;
+    pnm_set_channel(imd, J, c);
+    memory_free(J);
+    memory_free(I);
+  }
+  return n;
+}
+
+void
+fill_holes(pnm ims, pnm imd)
+{
+  int w = pnm_get_width(ims);
+  int h = pnm_get_height(ims);
+
+  // Reconstruction of the complement from its border values: the holes
+  // are the minima that cannot be reached from the border
+  for(int c = 0; c < 3; c++){
+    unsigned short *I = pnm_get_channel(ims, NULL, c);
+    unsigned short *J = memory_calloc(w*h*sizeof(unsigned short));
+    for(int p = 0; p < w*h; p++)
+      I[p] = pnm_maxval - I[p];
+    for(int i = 0; i < h; i++)
+      for(int j = 0; j < w; j++)
+	if(i == 0 || i == h-1 || j == 0 || j == w-1)
+	  J[i*w+j] = I[i*w+j];
+    L_reconstruct(w, h, J, I);
+    for(int p = 0; p < w*h; p++)
+      J[p] = pnm_maxval - J[p];
+    pnm_set_channel(imd, J, c);
+    memory_free(J);
+    memory_free(I);
+  }
+}
+
+void
+regional_maxima(pnm ims, pnm imd)
+{
+  int w = pnm_get_width(ims);
+  int h = pnm_get_height(ims);
+
+  // A pixel is a regional maximum when the reconstruction of f-1 under f
+  // does not reach it
+  for(int c = 0; c < 3; c++){
+    unsigned short *I = pnm_get_channel(ims, NULL, c);
+    unsigned short *J = memory_alloc(w*h*sizeof(unsigned short));
+    for(int p = 0; p < w*h; p++)
+      J[p] = I[p] > 0 ? I[p]-1 : 0;
+    L_reconstruct(w, h, J, I);
+    for(int p = 0; p < w*h; p++)
+      J[p] = I[p] > J[p] ? pnm_maxval : 0;
+    pnm_set_channel(imd, J, c);
+    memory_free(J);
+    memory_free(I);
+  }
+}
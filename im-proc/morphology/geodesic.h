@@ -0,0 +1,52 @@
+#ifndef __GEODESIC_HH__
+#define __GEODESIC_HH__
+
+/**
+ *  @file  geodesic.h
+ *  @brief header for geodesic.c that implements geodesic reconstruction
+ *         and the operators built on it. Images are processed channel by
+ *         channel with the 8-connectivity.
+ */
+#include <pnm.h>
+
+/**
+ * @brief  compute the reconstruction by dilation of a marker under a mask
+ *         with the hybrid algorithm of L. Vincent (raster and anti-raster
+ *         scans followed by a FIFO propagation)
+ * @param  marker: the marker image, clipped by the mask
+ * @param  mask: the mask image
+ * @param  imd: the destination image
+ */
+void
+reconstruction(pnm marker, pnm mask, pnm imd);
+
+/**
+ * @brief  compute the reconstruction by dilation by iterating elementary
+ *         geodesic dilations until stability, kept as a reference for
+ *         benchmarking the hybrid algorithm
+ * @param  marker: the marker image, clipped by the mask
+ * @param  mask: the mask image
+ * @param  imd: the destination image
+ * @return the number of iterations needed to reach stability
+ */
+int
+reconstruction_naive(pnm marker, pnm mask, pnm imd);
+
+/**
+ * @brief  fill the holes of an image, i.e. the regional minima not
+ *         connected to the image border
+ * @param  ims: the input image source to process
+ * @param  imd: the destination image
+ */
+void
+fill_holes(pnm ims, pnm imd);
+
+/**
+ * @brief  compute the regional maxima of an image as a binary image
+ * @param  ims: the input image source to process
+ * @param  imd: the destination image, pnm_maxval on the maxima and 0 elsewhere
+ */
+void
+regional_maxima(pnm ims, pnm imd);
+
+#endif
@@ -0,0 +1,61 @@
+/**
+ * @file  granulometry.c
+ * @brief compute the pattern spectrum of an image: the volume removed by
+ *        the opening of each halfsize from 1 to n, i.e. the amount of
+ *        structures whose size matches it. It is printed as a CSV table of
+ *        the opening volumes and of the spectrum, normalized by the volume
+ *        of the image, followed by a bar chart of the spectrum.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <bcl.h>
+#include <morphology.h>
+
+void
+usage(char* s)
+{
+  fprintf(stderr,"%s <se> <n> <ims>\n",s);
+  exit(EXIT_FAILURE);
+}
+
+#define BAR 50
+
+#define PARAM 3
+int
+main(int argc, char* argv[])
+{
+  if(argc != PARAM+1) usage(argv[0]);
+  int     s       = atoi(argv[1]);
+  int     n       = atoi(argv[2]);
+  if(n < 1) usage(argv[0]);
+  pnm     ims     = pnm_load(argv[3]);
+  double *volumes = memory_alloc((n+1)*sizeof(double));
+  double *ps      = memory_alloc((n+1)*sizeof(double));
+  double  max     = 0;
+
+  granulometry(s, n, ims, volumes);
+  for(int hs = 1; hs <= n; hs++){
+    ps[hs] = volumes[0] > 0 ? (volumes[hs-1]-volumes[hs])/volumes[0] : 0;
+    if(ps[hs] > max)
+      max = ps[hs];
+  }
+
+  printf("hs,volume,spectrum\n");
+  for(int hs = 0; hs <= n; hs++)
+    printf("%d,%.0f,%f\n", hs, volumes[hs], hs > 0 ? ps[hs] : 0);
+  printf("\n");
+  for(int hs = 1; hs <= n; hs++){
+    int len = max > 0 ? (int)(BAR*ps[hs]/max+0.5) : 0;
+    printf("%3d |", hs);
+    for(int k = 0; k < len; k++)
+      putchar('#');
+    printf("\n");
+  }
+
+  memory_free(volumes);
+  memory_free(ps);
+  pnm_free(ims);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,173 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <bcl.h>
+#include <maxtree.h>
+
+static int
+L_find(int p, int *zpar)
+{
+  while(zpar[p] != p){
+    zpar[p] = zpar[zpar[p]];
+    p = zpar[p];
+  }
+  return p;
+}
+
+/**
+ * @brief  sort the pixels by increasing level with a counting sort
+ */
+static void
+L_sort(const unsigned short *levels, int n, int *order)
+{
+  int *count = memory_calloc((pnm_maxval+2)*sizeof(int));
+
+  for(int p = 0; p < n; p++)
+    count[levels[p]+1]++;
+  for(int v = 1; v <= pnm_maxval; v++)
+    count[v] += count[v-1];
+  for(int p = 0; p < n; p++)
+    order[count[levels[p]]++] = p;
+  memory_free(count);
+}
+
+maxtree
+maxtree_new(int w, int h, const unsigned short *levels, int stride, int dual)
+{
+  maxtree self = memory_alloc(sizeof(struct maxtree));
+  int     n    = w*h;
+  int    *zpar = memory_alloc(n*sizeof(int));
+
+  self->width  = w;
+  self->height = h;
+  self->dual   = dual;
+  self->levels = memory_alloc(n*sizeof(unsigned short));
+  self->parent = memory_alloc(n*sizeof(int));
+  self->order  = memory_alloc(n*sizeof(int));
+  self->area   = memory_alloc(n*sizeof(int));
+  self->top    = memory_alloc(n*sizeof(unsigned short));
+  self->xmin   = memory_alloc(n*sizeof(int));
+  self->ymin   = memory_alloc(n*sizeof(int));
+  self->xmax   = memory_alloc(n*sizeof(int));
+  self->ymax   = memory_alloc(n*sizeof(int));
+
+  unsigned short *f      = self->levels;
+  int            *parent = self->parent;
+  int            *order  = self->order;
+  for(int p = 0; p < n; p++)
+    f[p] = dual ? pnm_maxval-levels[p*stride] : levels[p*stride];
+  L_sort(f, n, order);
+
+  // Pixels are added from the highest level, each one becoming the parent
+  // of the roots of the already built components it touches
+  for(int p = 0; p < n; p++)
+    zpar[p] = -1;
+  for(int k = n-1; k >= 0; k--){
+    int p = order[k];
+    int i = p/w;
+    int j = p%w;
+    parent[p] = p;
+    zpar[p]   = p;
+    for(int di = -1; di <= 1; di++)
+      for(int dj = -1; dj <= 1; dj++){
+	int y = i+di;
+	int x = j+dj;
+	if(y < 0 || y >= h || x < 0 || x >= w || zpar[y*w+x] < 0)
+	  continue;
+	int r = L_find(y*w+x, zpar);
+	if(r != p){
+	  parent[r] = p;
+	  zpar[r]   = p;
+	}
+      }
+  }
+  memory_free(zpar);
+
+  // The first pixel of a node in the order is its canonical pixel, every
+  // other one pointing to it
+  for(int k = 0; k < n; k++){
+    int p = order[k];
+    int q = parent[p];
+    if(f[parent[q]] == f[q])
+      parent[p] = parent[q];
+  }
+
+  for(int p = 0; p < n; p++){
+    self->area[p] = 1;
+    self->top[p]  = f[p];
+    self->xmin[p] = self->xmax[p] = p%w;
+    self->ymin[p] = self->ymax[p] = p/w;
+  }
+  for(int k = n-1; k > 0; k--){
+    int p = order[k];
+    int q = parent[p];
+    self->area[q] += self->area[p];
+    if(self->top[p] > self->top[q]) self->top[q] = self->top[p];
+    if(self->xmin[p] < self->xmin[q]) self->xmin[q] = self->xmin[p];
+    if(self->ymin[p] < self->ymin[q]) self->ymin[q] = self->ymin[p];
+    if(self->xmax[p] > self->xmax[q]) self->xmax[q] = self->xmax[p];
+    if(self->ymax[p] > self->ymax[q]) self->ymax[q] = self->ymax[p];
+  }
+  return self;
+}
+
+void
+maxtree_free(maxtree self)
+{
+  memory_free(self->levels);
+  memory_free(self->parent);
+  memory_free(self->order);
+  memory_free(self->area);
+  memory_free(self->top);
+  memory_free(self->xmin);
+  memory_free(self->ymin);
+  memory_free(self->xmax);
+  memory_free(self->ymax);
+  memory_free(self);
+}
+
+static int
+L_attribute(maxtree self, int attribute, int p)
+{
+  int dx, dy;
+
+  switch(attribute){
+  case AREA:
+    return self->area[p];
+  case HEIGHT:
+    return self->top[p] - self->levels[self->parent[p]];
+  case BBOX:
+    dx = self->xmax[p] - self->xmin[p];
+    dy = self->ymax[p] - self->ymin[p];
+    return (dx > dy ? dx : dy) + 1;
+  default:
+    fprintf(stderr, "maxtree_filter: unknown attribute %d\n", attribute);
+    exit(EXIT_FAILURE);
+  }
+}
+
+void
+maxtree_filter(maxtree self, int attribute, int lambda,
+	       unsigned short *out, int stride)
+{
+  int             n      = self->width*self->height;
+  unsigned short *f      = self->levels;
+  int            *parent = self->parent;
+  unsigned short *v      = memory_alloc(n*sizeof(unsigned short));
+
+  // The root comes first and the parent of a pixel always precedes it, so
+  // removed nodes take the value of their closest kept ancestor
+  for(int k = 0; k < n; k++){
+    int p = self->order[k];
+    int q = parent[p];
+    if(k == 0)
+      v[p] = f[p];
+    else if(f[q] == f[p])
+      v[p] = v[q];
+    else
+      v[p] = L_attribute(self, attribute, p) >= lambda ? f[p] : v[q];
+  }
+  for(int p = 0; p < n; p++)
+    out[p*stride] = self->dual ? pnm_maxval-v[p] : v[p];
+  memory_free(v);
+}
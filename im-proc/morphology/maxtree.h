@@ -0,0 +1,70 @@
+#ifndef __MAXTREE_HH__
+#define __MAXTREE_HH__
+
+/**
+ *  @file  maxtree.h
+ *  @brief header for maxtree.c that implements the max-tree of a grayscale
+ *         image, the tree of the 8-connected components of its upper level
+ *         sets, and the attribute openings and closings filtering it. The
+ *         tree is built once by union-find (Berger et al.) together with
+ *         the attributes of its nodes, each filter being then a single
+ *         pass over the pixels.
+ */
+
+enum {AREA, HEIGHT, BBOX};
+
+typedef struct maxtree *maxtree;
+
+struct maxtree
+{
+  int             width;
+  int             height;
+  int             dual;    /* min-tree built on the complemented image */
+  unsigned short *levels;  /* the levels the tree is built on */
+  int            *parent;  /* parent of each pixel, the canonical pixel of
+			      its node or of the parent node */
+  int            *order;   /* pixels by increasing level, root first */
+  int            *area;    /* number of pixels of each node */
+  unsigned short *top;     /* highest level of each node */
+  int            *xmin;    /* bounding box of each node */
+  int            *ymin;
+  int            *xmax;
+  int            *ymax;
+};
+
+/**
+ * @brief  build the max-tree of a grayscale image, or its min-tree
+ * @param  w: the image width
+ * @param  h: the image height
+ * @param  levels: the image values, between 0 and pnm_maxval
+ * @param  stride: the distance between two values of levels
+ * @param  dual: 0 for the max-tree, 1 for the min-tree
+ * @return the new tree
+ */
+maxtree
+maxtree_new(int w, int h, const unsigned short *levels, int stride, int dual);
+
+/**
+ * @brief  release a tree
+ * @param  self: the tree to free
+ */
+void
+maxtree_free(maxtree self);
+
+/**
+ * @brief  attribute opening (max-tree) or closing (min-tree): the nodes
+ *         whose attribute is lower than the threshold are merged into
+ *         their parent. The attributes are the number of pixels (AREA),
+ *         the contrast of the node over its parent (HEIGHT) and the larger
+ *         side of its bounding box (BBOX), all increasing.
+ * @param  self: the tree
+ * @param  attribute: the attribute to threshold
+ * @param  lambda: the threshold
+ * @param  out: the filtered values output
+ * @param  stride: the distance between two values of out
+ */
+void
+maxtree_filter(maxtree self, int attribute, int lambda,
+	       unsigned short *out, int stride);
+
+#endif
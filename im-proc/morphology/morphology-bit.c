@@ -2,30 +2,43 @@
 
 #include <morphology.h>
 #include <se.h>
+#include <bitplane.h>
 
-void 
-maximum(unsigned short *val, unsigned short *min){ 
-  (void) val;
-  (void) min;
+/*
+ * Binary morphology on bit-packed images: the red channel of the source is
+ * thresholded into a bit plane, processed 64 pixels per word operation and
+ * unpacked into the three channels of the destination.
+ */
+
+void
+maximum(unsigned short *val, unsigned short *max){
+  if(*val > *max)
+    *max = *val;
 }
 
-void 
-minimum(unsigned short *val, unsigned short *max){ 
-  (void) val;
-  (void) max;
+void
+minimum(unsigned short *val, unsigned short *min){
+  if(*val < *min)
+    *min = *val;
 }
 
-void 
-process(int s, 
-	int hs, 
-	pnm ims, 
-	pnm imd, 
+void
+process(int s,
+	int hs,
+	pnm ims,
+	pnm imd,
 	void (*pf)(unsigned short*, unsigned short*))
-{  
-  (void) s;
-  (void) hs;
-  (void) ims;
-  (void) imd;
-  (void) pf;
-  puts(">> morphology-bit.c");
+{
+  pnm      shape = se_compile(s, hs, 0)->image;
+  bitplane bs    = bitplane_pack(ims, PnmRed);
+  bitplane bd    = bitplane_new(bs->width, bs->height);
+
+  if(pf == minimum)
+    bitplane_erode(bs, bd, shape);
+  else
+    bitplane_dilate(bs, bd, shape);
+  bitplane_unpack(bd, imd);
+
+  bitplane_free(bs);
+  bitplane_free(bd);
 }
@@ -1,31 +1,109 @@
+#include <stdint.h>
 #include <math.h>
 
 #include <morphology.h>
 #include <se.h>
 
-void 
-maximum(unsigned short *val, unsigned short *min){ 
-  (void) val;
-  (void) min;
+/*
+ * Color morphology with a lexicographic ordering of RGB vectors. Instead of
+ * comparing the three components for each neighbour, every pixel is packed
+ * once into a 64-bit key R<<32|G<<16|B whose integer order is the
+ * lexicographic order, so dilation and erosion become a plain max/min over
+ * keys that are unpacked at the end.
+ */
+
+void
+maximum(unsigned short *val, unsigned short *max){
+  for(int c = 0; c < 3; c++){
+    if(val[c] != max[c]){
+      if(val[c] > max[c])
+	for(int k = 0; k < 3; k++)
+	  max[k] = val[k];
+      return;
+    }
+  }
 }
 
-void 
-minimum(unsigned short *val, unsigned short *max){ 
-  (void) val;
-  (void) max;
+void
+minimum(unsigned short *val, unsigned short *min){
+  for(int c = 0; c < 3; c++){
+    if(val[c] != min[c]){
+      if(val[c] < min[c])
+	for(int k = 0; k < 3; k++)
+	  min[k] = val[k];
+      return;
+    }
+  }
 }
 
-void 
-process(int s, 
-	int hs, 
-	pnm ims, 
-	pnm imd, 
+/**
+ * @brief  max or min of the keys under the structuring element, the offsets
+ *         being linear when the whole element lies inside the image
+ */
+static void
+L_order(int w, int h, int hs, int n, const int *di, const int *dj,
+	const uint64_t *keys, uint64_t *res, int dilate)
+{
+  int *off = memory_alloc(n*sizeof(int));
+  for(int k = 0; k < n; k++)
+    off[k] = di[k]*w + dj[k];
+
+  for(int i = 0; i < h; i++){
+    int inner = i >= hs && i < h-hs;
+    for(int j = 0; j < w; j++){
+      int      p = i*w+j;
+      uint64_t v = keys[p];
+      if(inner && j >= hs && j < w-hs){
+	if(dilate){
+	  for(int k = 0; k < n; k++)
+	    if(keys[p+off[k]] > v) v = keys[p+off[k]];
+	}else{
+	  for(int k = 0; k < n; k++)
+	    if(keys[p+off[k]] < v) v = keys[p+off[k]];
+	}
+      }else{
+	for(int k = 0; k < n; k++){
+	  int y = i+di[k];
+	  int x = j+dj[k];
+	  if(y < 0 || y >= h || x < 0 || x >= w)
+	    continue;
+	  uint64_t u = keys[y*w+x];
+	  if(dilate ? u > v : u < v) v = u;
+	}
+      }
+      res[p] = v;
+    }
+  }
+  memory_free(off);
+}
+
+void
+process(int s,
+	int hs,
+	pnm ims,
+	pnm imd,
 	void (*pf)(unsigned short*, unsigned short*))
-{  
-  (void) s;
-  (void) hs;
-  (void) ims;
-  (void) imd;
-  (void) pf;
-  puts(">> morphology-lex.c");
+{
+  int             w     = pnm_get_width(ims);
+  int             h     = pnm_get_height(ims);
+  unsigned short *ps    = pnm_get_image(ims);
+  unsigned short *pd    = pnm_get_image(imd);
+  uint64_t       *keys  = memory_alloc(w*h*sizeof(uint64_t));
+  uint64_t       *res   = memory_alloc(w*h*sizeof(uint64_t));
+
+  const struct se_compiled *b = se_compile(s, hs, w);
+
+  for(int p = 0; p < w*h; p++, ps += 3)
+    keys[p] = (uint64_t)ps[0] << 32 | (uint64_t)ps[1] << 16 | ps[2];
+
+  L_order(w, h, hs, b->size, b->di, b->dj, keys, res, pf != minimum);
+
+  for(int p = 0; p < w*h; p++){
+    *pd++ = (unsigned short)(res[p] >> 32);
+    *pd++ = (unsigned short)(res[p] >> 16);
+    *pd++ = (unsigned short)res[p];
+  }
+
+  memory_free(keys);
+  memory_free(res);
 }
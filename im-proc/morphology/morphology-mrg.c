@@ -3,29 +3,106 @@
 #include <morphology.h>
 #include <se.h>
 
-void 
-maximum(unsigned short *val, unsigned short *min){ 
-  (void) val;
-  (void) min;
+/*
+ * Color morphology with a reduced (merged) ordering: RGB vectors are ordered
+ * by their luminance. The rank of every pixel is computed once into a side
+ * buffer, dilation and erosion only track the index of the extremal rank
+ * under the structuring element and the RGB triple is gathered at the end.
+ */
+
+/**
+ * @brief  integer luminance used as the rank of a RGB vector
+ */
+static unsigned int
+L_rank(const unsigned short *rgb)
+{
+  return 299*rgb[0] + 587*rgb[1] + 114*rgb[2];
+}
+
+void
+maximum(unsigned short *val, unsigned short *max){
+  if(L_rank(val) > L_rank(max))
+    for(int c = 0; c < 3; c++)
+      max[c] = val[c];
 }
 
-void 
-minimum(unsigned short *val, unsigned short *max){ 
-  (void) val;
-  (void) max;
+void
+minimum(unsigned short *val, unsigned short *min){
+  if(L_rank(val) < L_rank(min))
+    for(int c = 0; c < 3; c++)
+      min[c] = val[c];
+}
+
+/**
+ * @brief  index of the pixel of extremal rank under the structuring element,
+ *         the offsets being linear when the whole element lies inside the
+ *         image
+ */
+static void
+L_select(int w, int h, int hs, int n, const int *di, const int *dj,
+	 const unsigned int *rank, int *arg, int dilate)
+{
+  int *off = memory_alloc(n*sizeof(int));
+  for(int k = 0; k < n; k++)
+    off[k] = di[k]*w + dj[k];
+
+  for(int i = 0; i < h; i++){
+    int inner = i >= hs && i < h-hs;
+    for(int j = 0; j < w; j++){
+      int p = i*w+j;
+      int a = p;
+      if(inner && j >= hs && j < w-hs){
+	if(dilate){
+	  for(int k = 0; k < n; k++)
+	    if(rank[p+off[k]] > rank[a]) a = p+off[k];
+	}else{
+	  for(int k = 0; k < n; k++)
+	    if(rank[p+off[k]] < rank[a]) a = p+off[k];
+	}
+      }else{
+	for(int k = 0; k < n; k++){
+	  int y = i+di[k];
+	  int x = j+dj[k];
+	  if(y < 0 || y >= h || x < 0 || x >= w)
+	    continue;
+	  int q = y*w+x;
+	  if(dilate ? rank[q] > rank[a] : rank[q] < rank[a]) a = q;
+	}
+      }
+      arg[p] = a;
+    }
+  }
+  memory_free(off);
 }
 
-void 
-process(int s, 
-	int hs, 
-	pnm ims, 
-	pnm imd, 
+void
+process(int s,
+	int hs,
+	pnm ims,
+	pnm imd,
 	void (*pf)(unsigned short*, unsigned short*))
-{  
-  (void) s;
-  (void) hs;
-  (void) ims;
-  (void) imd;
-  (void) pf;
-  puts(">> morphology-mrg.c");
+{
+  int             w     = pnm_get_width(ims);
+  int             h     = pnm_get_height(ims);
+  unsigned short *ps    = pnm_get_image(ims);
+  unsigned short *pd    = pnm_get_image(imd);
+  unsigned int   *rank  = memory_alloc(w*h*sizeof(unsigned int));
+  int            *arg   = memory_alloc(w*h*sizeof(int));
+
+  const struct se_compiled *b = se_compile(s, hs, w);
+
+  for(int p = 0; p < w*h; p++)
+    rank[p] = L_rank(ps + 3*p);
+
+  L_select(w, h, hs, b->size, b->di, b->dj, rank, arg, pf != minimum);
+
+  for(int p = 0; p < w*h; p++){
+    unsigned short *rgb = ps + 3*arg[p];
+    *pd++ = rgb[0];
+    *pd++ = rgb[1];
+    *pd++ = rgb[2];
+  }
+
+  memory_free(rank);
+  memory_free(arg);
 }
@@ -3,29 +3,52 @@
 #include <morphology.h>
 #include <se.h>
 
-void 
-maximum(unsigned short *val, unsigned short *min){ 
-  (void) val;
-  (void) min;
+void
+maximum(unsigned short *val, unsigned short *max){
+  if(*val > *max)
+    *max = *val;
 }
 
-void 
-minimum(unsigned short *val, unsigned short *max){ 
-  (void) val;
-  (void) max;
+void
+minimum(unsigned short *val, unsigned short *min){
+  if(*val < *min)
+    *min = *val;
 }
 
-void 
-process(int s, 
-	int hs, 
-	pnm ims, 
-	pnm imd, 
+void
+process(int s,
+	int hs,
+	pnm ims,
+	pnm imd,
 	void (*pf)(unsigned short*, unsigned short*))
-{  
-  (void) s;
-  (void) hs;
-  (void) ims;
-  (void) imd;
-  (void) pf;
-  puts(">> morphology.c");
+{
+  int             w     = pnm_get_width(ims);
+  int             h     = pnm_get_height(ims);
+  unsigned short *ps    = pnm_get_image(ims);
+  unsigned short *pd    = pnm_get_image(imd);
+
+  const struct se_compiled *b = se_compile(s, hs, w);
+
+  for(int i = 0; i < h; i++){
+    int inner = i >= hs && i < h-hs;
+    for(int j = 0; j < w; j++){
+      for(int c = 0; c < 3; c++){
+	int            p = PNM_OFFSET(w, i, j)+c;
+	unsigned short v = ps[p];
+	if(inner && j >= hs && j < w-hs){
+	  // The whole element lies inside the image
+	  for(int k = 0; k < b->size; k++)
+	    (*pf)(&ps[p+b->offsets[k]], &v);
+	}else{
+	  for(int k = 0; k < b->size; k++){
+	    int y = i+b->di[k];
+	    int x = j+b->dj[k];
+	    if(y >= 0 && y < h && x >= 0 && x < w)
+	      (*pf)(&ps[PNM_OFFSET(w, y, x)+c], &v);
+	  }
+	}
+	pd[p] = v;
+      }
+    }
+  }
 }
@@ -46,4 +46,69 @@ maximum(unsigned short *val, unsigned short *max);
 void
 minimum(unsigned short *val, unsigned short *min);
 
+/**
+ * @brief  compute a morphological opening (erosion followed by dilation)
+ * @param  shape: the structing element shape umber
+ * @param  halfsize: the structuring element halfsize
+ * @param  ims: the input image source to process
+ * @param  imd: the destination image
+ */
+void
+opening(int shape, int halfsize, pnm ims, pnm imd);
+
+/**
+ * @brief  compute a morphological closing (dilation followed by erosion)
+ * @param  shape: the structing element shape umber
+ * @param  halfsize: the structuring element halfsize
+ * @param  ims: the input image source to process
+ * @param  imd: the destination image
+ */
+void
+closing(int shape, int halfsize, pnm ims, pnm imd);
+
+/**
+ * @brief  compute a morphological gradient (dilation minus erosion), both
+ *         extrema being found in a single sweep of each channel
+ * @param  shape: the structing element shape umber
+ * @param  halfsize: the structuring element halfsize
+ * @param  ims: the input image source to process
+ * @param  imd: the destination image
+ */
+void
+gradient(int shape, int halfsize, pnm ims, pnm imd);
+
+/**
+ * @brief  compute a white top-hat (image minus its opening)
+ * @param  shape: the structing element shape umber
+ * @param  halfsize: the structuring element halfsize
+ * @param  ims: the input image source to process
+ * @param  imd: the destination image
+ */
+void
+white_top_hat(int shape, int halfsize, pnm ims, pnm imd);
+
+/**
+ * @brief  compute a black top-hat (closing of the image minus the image)
+ * @param  shape: the structing element shape umber
+ * @param  halfsize: the structuring element halfsize
+ * @param  ims: the input image source to process
+ * @param  imd: the destination image
+ */
+void
+black_top_hat(int shape, int halfsize, pnm ims, pnm imd);
+
+/**
+ * @brief  compute the granulometry of an image, the volume (sum of the
+ *         values of the three channels) of its openings by structuring
+ *         elements of halfsize 0 to n. Square, diamond and line shapes are
+ *         built by successive dilations of their halfsize 1 element, so each
+ *         opening reuses the erosion of the previous size.
+ * @param  shape: the structing element shape umber
+ * @param  n: the largest halfsize
+ * @param  ims: the input image source to process
+ * @param  volumes: the volumes output, of n+1 entries
+ */
+void
+granulometry(int shape, int n, pnm ims, double *volumes);
+
 #endif
@@ -0,0 +1,25 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <morphology.h>
+
+void
+usage(char* s)
+{
+  fprintf(stderr,"%s <se> <hs> <ims> <imd>\n",s);
+  exit(EXIT_FAILURE);
+}
+
+#define PARAM 4
+int
+main(int argc, char* argv[])
+{
+  if(argc != PARAM+1) usage(argv[0]);
+  pnm ims = pnm_load(argv[3]);
+  pnm imd = pnm_new(pnm_get_width(ims), pnm_get_height(ims), PnmRawPpm);
+  opening(atoi(argv[1]), atoi(argv[2]), ims, imd);
+  pnm_save(imd, PnmRawPpm, argv[4]);
+  pnm_free(ims);
+  pnm_free(imd);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,273 @@
+#include <bcl.h>
+#include <rle.h>
+
+rle
+rle_new(int width, int height)
+{
+  rle self = memory_alloc(sizeof(struct rle));
+  self->width    = width;
+  self->height   = height;
+  self->rows     = memory_calloc((height+1)*sizeof(int));
+  self->size     = 0;
+  self->capacity = height > 0 ? height : 1;
+  self->runs     = memory_alloc(self->capacity*sizeof(struct run));
+  return self;
+}
+
+void
+rle_free(rle self)
+{
+  memory_free(self->rows);
+  memory_free(self->runs);
+  memory_free(self);
+}
+
+/**
+ * @brief  append a run to the row starting at the run first, runs being
+ *         appended by increasing x0 and merged when they overlap or touch
+ */
+static void
+L_append(rle self, int first, int x0, int x1)
+{
+  if(self->size > first && self->runs[self->size-1].x1+1 >= x0){
+    if(x1 > self->runs[self->size-1].x1)
+      self->runs[self->size-1].x1 = x1;
+    return;
+  }
+  if(self->size == self->capacity){
+    self->capacity *= 2;
+    self->runs = memory_realloc(self->runs, self->capacity*sizeof(struct run));
+  }
+  self->runs[self->size].x0 = x0;
+  self->runs[self->size].x1 = x1;
+  self->size++;
+}
+
+rle
+rle_encode(pnm ims, pnmChannel channel)
+{
+  int             w    = pnm_get_width(ims);
+  int             h    = pnm_get_height(ims);
+  unsigned short *ps   = pnm_get_image(ims) + channel;
+  rle             self = rle_new(w, h);
+
+  for(int i = 0; i < h; i++){
+    self->rows[i] = self->size;
+    for(int j = 0; j < w; j++){
+      if(ps[3*(i*w+j)] <= pnm_maxval/2)
+	continue;
+      int x0 = j;
+      while(j+1 < w && ps[3*(i*w+j+1)] > pnm_maxval/2)
+	j++;
+      L_append(self, self->rows[i], x0, j);
+    }
+  }
+  self->rows[h] = self->size;
+  return self;
+}
+
+void
+rle_decode(rle self, pnm imd)
+{
+  int             w  = self->width;
+  unsigned short *pd = pnm_get_image(imd);
+
+  for(int p = 0; p < 3*w*self->height; p++)
+    pd[p] = 0;
+  for(int i = 0; i < self->height; i++)
+    for(int r = self->rows[i]; r < self->rows[i+1]; r++)
+      for(int j = self->runs[r].x0; j <= self->runs[r].x1; j++){
+	unsigned short *p = pd + 3*(i*w+j);
+	p[0] = p[1] = p[2] = pnm_maxval;
+      }
+}
+
+static int
+L_find(int p, int *roots)
+{
+  while(roots[p] != p){
+    roots[p] = roots[roots[p]];
+    p = roots[p];
+  }
+  return p;
+}
+
+static void
+L_union(int p, int q, int *roots, unsigned char *ranks)
+{
+  p = L_find(p, roots);
+  q = L_find(q, roots);
+  if(p == q)
+    return;
+  if(ranks[p] < ranks[q]){
+    roots[p] = q;
+    return;
+  }
+  if(ranks[p] == ranks[q])
+    ranks[p]++;
+  roots[q] = p;
+}
+
+int
+rle_label(rle self, int *labels)
+{
+  int            n     = self->size;
+  int           *roots = memory_alloc((n+1)*sizeof(int));
+  unsigned char *ranks = memory_calloc(n+1);
+  int            l     = 0;
+
+  for(int r = 0; r < n; r++)
+    roots[r] = r;
+
+  // Runs of consecutive rows are 8-connected when they overlap once
+  // extended by one pixel on each side
+  for(int i = 1; i < self->height; i++){
+    int a = self->rows[i-1];
+    int b = self->rows[i];
+    while(a < self->rows[i] && b < self->rows[i+1]){
+      struct run *ra = &self->runs[a];
+      struct run *rb = &self->runs[b];
+      if(ra->x0 <= rb->x1+1 && rb->x0 <= ra->x1+1)
+	L_union(a, b, roots, ranks);
+      if(ra->x1 < rb->x1+1)
+	a++;
+      else
+	b++;
+    }
+  }
+
+  for(int r = 0; r < n; r++)
+    labels[r] = 0;
+  for(int r = 0; r < n; r++){
+    int root = L_find(r, roots);
+    if(labels[root] == 0)
+      labels[root] = ++l;
+    labels[r] = labels[root];
+  }
+  memory_free(roots);
+  memory_free(ranks);
+  return l;
+}
+
+rle
+rle_dilate_h(rle self, int hs)
+{
+  int w   = self->width;
+  rle imd = rle_new(w, self->height);
+
+  for(int i = 0; i < self->height; i++){
+    imd->rows[i] = imd->size;
+    for(int r = self->rows[i]; r < self->rows[i+1]; r++){
+      int x0 = self->runs[r].x0-hs;
+      int x1 = self->runs[r].x1+hs;
+      L_append(imd, imd->rows[i], x0 < 0 ? 0 : x0, x1 >= w ? w-1 : x1);
+    }
+  }
+  imd->rows[self->height] = imd->size;
+  return imd;
+}
+
+rle
+rle_erode_h(rle self, int hs)
+{
+  int w   = self->width;
+  rle imd = rle_new(w, self->height);
+
+  // Pixels outside the image do not erode the runs touching the border
+  for(int i = 0; i < self->height; i++){
+    imd->rows[i] = imd->size;
+    for(int r = self->rows[i]; r < self->rows[i+1]; r++){
+      int x0 = self->runs[r].x0 == 0   ? 0   : self->runs[r].x0+hs;
+      int x1 = self->runs[r].x1 == w-1 ? w-1 : self->runs[r].x1-hs;
+      if(x0 <= x1)
+	L_append(imd, imd->rows[i], x0, x1);
+    }
+  }
+  imd->rows[self->height] = imd->size;
+  return imd;
+}
+
+/**
+ * @brief  union (op = 0) or intersection (op = 1) of two sorted run lists
+ * @return the number of runs written to c
+ */
+static int
+L_combine(const struct run *a, int na, const struct run *b, int nb,
+	  struct run *c, int op)
+{
+  int i = 0, j = 0, n = 0;
+
+  if(op == 0){
+    while(i < na || j < nb){
+      struct run r = (j >= nb || (i < na && a[i].x0 <= b[j].x0)) ? a[i++] : b[j++];
+      if(n > 0 && c[n-1].x1+1 >= r.x0){
+	if(r.x1 > c[n-1].x1)
+	  c[n-1].x1 = r.x1;
+      }else
+	c[n++] = r;
+    }
+  }else{
+    while(i < na && j < nb){
+      int x0 = a[i].x0 > b[j].x0 ? a[i].x0 : b[j].x0;
+      int x1 = a[i].x1 < b[j].x1 ? a[i].x1 : b[j].x1;
+      if(x0 <= x1){
+	c[n].x0 = x0;
+	c[n].x1 = x1;
+	n++;
+      }
+      if(a[i].x1 < b[j].x1)
+	i++;
+      else
+	j++;
+    }
+  }
+  return n;
+}
+
+/**
+ * @brief  vertical dilation (op = 0) or erosion (op = 1), each row being
+ *         combined with the rows of the window that lie inside the image
+ */
+static rle
+L_vertical(rle self, int hs, int op)
+{
+  int         h   = self->height;
+  rle         imd = rle_new(self->width, h);
+  struct run *acc = memory_alloc((self->width+1)*sizeof(struct run));
+  struct run *tmp = memory_alloc((self->width+1)*sizeof(struct run));
+
+  for(int i = 0; i < h; i++){
+    int y0 = i-hs < 0  ? 0   : i-hs;
+    int y1 = i+hs >= h ? h-1 : i+hs;
+    int n  = self->rows[y0+1]-self->rows[y0];
+    for(int r = 0; r < n; r++)
+      acc[r] = self->runs[self->rows[y0]+r];
+    for(int y = y0+1; y <= y1 && (op == 0 || n > 0); y++){
+      int m = L_combine(acc, n, self->runs+self->rows[y],
+			self->rows[y+1]-self->rows[y], tmp, op);
+      struct run *swap = acc;
+      acc = tmp;
+      tmp = swap;
+      n   = m;
+    }
+    imd->rows[i] = imd->size;
+    for(int r = 0; r < n; r++)
+      L_append(imd, imd->rows[i], acc[r].x0, acc[r].x1);
+  }
+  imd->rows[h] = imd->size;
+  memory_free(acc);
+  memory_free(tmp);
+  return imd;
+}
+
+rle
+rle_dilate_v(rle self, int hs)
+{
+  return L_vertical(self, hs, 0);
+}
+
+rle
+rle_erode_v(rle self, int hs)
+{
+  return L_vertical(self, hs, 1);
+}
@@ -0,0 +1,112 @@
+#ifndef __RLE_HH__
+#define __RLE_HH__
+
+/**
+ *  @file  rle.h
+ *  @brief header for rle.c that implements a run-length encoded
+ *         representation of binary images, and the labeling, dilation and
+ *         erosion by line structuring elements working directly on runs.
+ *         The runs of a row are sorted, disjoint and not adjacent.
+ */
+#include <pnm.h>
+
+struct run
+{
+  int x0;  /* first column of the run */
+  int x1;  /* last column of the run */
+};
+
+typedef struct rle *rle;
+
+struct rle
+{
+  int         width;
+  int         height;
+  int        *rows;      /* first run of each row, height+1 entries */
+  struct run *runs;
+  int         size;      /* number of runs */
+  int         capacity;
+};
+
+/**
+ * @brief  allocate an empty run-length encoded image
+ * @param  width: the image width
+ * @param  height: the image height
+ * @return the new image
+ */
+rle
+rle_new(int width, int height);
+
+/**
+ * @brief  release a run-length encoded image
+ * @param  self: the image to free
+ */
+void
+rle_free(rle self);
+
+/**
+ * @brief  encode one channel of a pnm image, pixels greater than
+ *         pnm_maxval/2 being the foreground
+ * @param  ims: the input image
+ * @param  channel: the channel to encode
+ * @return the new run-length encoded image
+ */
+rle
+rle_encode(pnm ims, pnmChannel channel);
+
+/**
+ * @brief  decode a run-length encoded image into the three channels of a
+ *         pnm image, pnm_maxval on the runs and 0 elsewhere
+ * @param  self: the image to decode
+ * @param  imd: the destination image, of the same size
+ */
+void
+rle_decode(rle self, pnm imd);
+
+/**
+ * @brief  label the 8-connected components of a run-length encoded image
+ * @param  self: the input image
+ * @param  labels: the label of each run, from 1 in the raster order of the
+ *         components, of self->size entries
+ * @return the number of components
+ */
+int
+rle_label(rle self, int *labels);
+
+/**
+ * @brief  dilation by a horizontal line of a given halfsize
+ * @param  self: the input image
+ * @param  halfsize: the line halfsize
+ * @return the new dilated image
+ */
+rle
+rle_dilate_h(rle self, int halfsize);
+
+/**
+ * @brief  erosion by a horizontal line of a given halfsize
+ * @param  self: the input image
+ * @param  halfsize: the line halfsize
+ * @return the new eroded image
+ */
+rle
+rle_erode_h(rle self, int halfsize);
+
+/**
+ * @brief  dilation by a vertical line of a given halfsize
+ * @param  self: the input image
+ * @param  halfsize: the line halfsize
+ * @return the new dilated image
+ */
+rle
+rle_dilate_v(rle self, int halfsize);
+
+/**
+ * @brief  erosion by a vertical line of a given halfsize
+ * @param  self: the input image
+ * @param  halfsize: the line halfsize
+ * @return the new eroded image
+ */
+rle
+rle_erode_v(rle self, int halfsize);
+
+#endif
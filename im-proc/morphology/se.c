@@ -1,11 +1,11 @@
+#define _POSIX_C_SOURCE 200112L
+
 #include <stdlib.h>
 #include <stdio.h>
-#include <math.h>
+#include <pthread.h>
 
 #include <se.h>
 
-enum {SQUARE, DIAMOND, DISK, LINE_V, DIAG_R, LINE_H, DIAG_L, CROSS, PLUS};
-
 void
 build_square(pnm imd)
 {
@@ -46,8 +46,8 @@ build_disk(pnm imd)
   int size = pnm_get_width(imd);
   for(int i = 0; i < size; i++){
     for(int j = 0; j < size; j++){
-      float offset = sqrt((size/2 - i) * (size/2 - i) + (size/2 - j) * (size/2 - j));
-      if(offset <= size/2){
+      int offset = (size/2 - i) * (size/2 - i) + (size/2 - j) * (size/2 - j);
+      if(offset <= (size/2) * (size/2)){
         for(int c = 0; c < 3; c++){
           pnm_set_component(imd, i, j, c, 255);
         }
@@ -142,3 +142,85 @@ se(int s, int hs)
   }
   return imd;
 }
+
+int
+se_points(int s, int hs, int *di, int *dj)
+{
+  const struct se_compiled *b = se_compile(s, hs, 0);
+  for(int k = 0; k < b->size; k++){
+    di[k] = b->di[k];
+    dj[k] = b->dj[k];
+  }
+  return b->size;
+}
+
+static struct se_compiled **cache          = NULL;
+static int                  cache_size     = 0;
+static int                  cache_capacity = 0;
+static pthread_mutex_t      cache_lock     = PTHREAD_MUTEX_INITIALIZER;
+
+static struct se_compiled *
+L_build(int s, int hs, int stride)
+{
+  struct se_compiled *self = memory_alloc(sizeof(struct se_compiled));
+  int                 size = 2*hs+1;
+
+  self->shape        = s;
+  self->halfsize     = hs;
+  self->stride       = stride;
+  self->image        = se(s, hs);
+  self->di           = memory_alloc(size*size*sizeof(int));
+  self->dj           = memory_alloc(size*size*sizeof(int));
+  self->offsets      = memory_alloc(size*size*sizeof(int));
+  self->decomposable = s == SQUARE || s == DIAMOND || s == LINE_V ||
+    s == LINE_H || s == DIAG_R || s == DIAG_L;
+  self->size         = 0;
+  for(int i = 0; i < size; i++)
+    for(int j = 0; j < size; j++)
+      if(pnm_get_component(self->image, i, j, PnmRed) == 255){
+        self->di[self->size]      = i-hs;
+        self->dj[self->size]      = j-hs;
+        self->offsets[self->size] = PNM_OFFSET(stride, i-hs, j-hs);
+        self->size++;
+      }
+  return self;
+}
+
+const struct se_compiled *
+se_compile(int s, int hs, int stride)
+{
+  struct se_compiled *self = NULL;
+
+  pthread_mutex_lock(&cache_lock);
+  for(int k = 0; k < cache_size && self == NULL; k++)
+    if(cache[k]->shape == s && cache[k]->halfsize == hs &&
+       cache[k]->stride == stride)
+      self = cache[k];
+  if(self == NULL){
+    if(cache_size == cache_capacity){
+      cache_capacity = cache_capacity ? 2*cache_capacity : 16;
+      cache = memory_realloc(cache, cache_capacity*sizeof(*cache));
+    }
+    self = cache[cache_size++] = L_build(s, hs, stride);
+  }
+  pthread_mutex_unlock(&cache_lock);
+  return self;
+}
+
+void
+se_cache_clear(void)
+{
+  pthread_mutex_lock(&cache_lock);
+  for(int k = 0; k < cache_size; k++){
+    pnm_free(cache[k]->image);
+    memory_free(cache[k]->di);
+    memory_free(cache[k]->dj);
+    memory_free(cache[k]->offsets);
+    memory_free(cache[k]);
+  }
+  memory_free(cache);
+  cache          = NULL;
+  cache_size     = 0;
+  cache_capacity = 0;
+  pthread_mutex_unlock(&cache_lock);
+}
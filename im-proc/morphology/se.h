@@ -1,6 +1,9 @@
+#ifndef __SE_HH__
+#define __SE_HH__
+
 #include <bcl.h>
 
-//enum {SQUARE, DIAMOND, DISK, LINE_V, DIAG_R, LINE_H, DIAG_L, CROSS, PLUS};
+enum {SQUARE, DIAMOND, DISK, LINE_V, DIAG_R, LINE_H, DIAG_L, CROSS, PLUS};
 /**
  * @brief  generate a structuring element of a given shape and halfsize 
  * @param  shape: the structing element shape umber, can be defined with the 
@@ -11,3 +14,51 @@
 pnm 
 se(int shape, int halfsize); 
 
+
+/**
+ * @brief  list the points of a structuring element as offsets from its center
+ * @param  shape: the structing element shape number
+ * @param  halfsize: the structuring element halfsize
+ * @param  di: the line offsets output, of (2*halfsize+1)^2 size
+ * @param  dj: the column offsets output, of (2*halfsize+1)^2 size
+ * @return the number of points of the structuring element
+ */
+int
+se_points(int shape, int halfsize, int *di, int *dj);
+
+/*
+ * Compiled structuring elements are built once per shape, halfsize and
+ * image width, and shared by all the images and threads of the process.
+ */
+struct se_compiled
+{
+  int  shape;
+  int  halfsize;
+  int  stride;        /* image width the offsets are computed for */
+  int  size;          /* number of points */
+  int *di;            /* line offsets from the center */
+  int *dj;            /* column offsets from the center */
+  int *offsets;       /* PNM_OFFSET(stride, di, dj) of each point */
+  int  decomposable;  /* the element of halfsize n+1 is the dilation of the
+			 one of halfsize n by the one of halfsize 1 */
+  pnm  image;         /* the element as a pnm binary image */
+};
+
+/**
+ * @brief  get the compiled form of a structuring element from the cache,
+ *         building it on the first request
+ * @param  shape: the structing element shape number
+ * @param  halfsize: the structuring element halfsize
+ * @param  stride: the width of the images it is applied to
+ * @return the compiled structuring element, owned by the cache
+ */
+const struct se_compiled *
+se_compile(int shape, int halfsize, int stride);
+
+/**
+ * @brief  release all the compiled structuring elements of the cache
+ */
+void
+se_cache_clear(void);
+
+#endif
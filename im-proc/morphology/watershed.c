@@ -0,0 +1,73 @@
+/**
+ * @file  watershed.c
+ * @brief segment an image by flooding it from markers
+ *
+ * The markers are a label image as saved by labeling, labels being coded
+ * on 24 bits from the red to the blue channel and the background being 0.
+ * The image to flood is read from its red channel, usually the output of
+ * gradient. Every pixel reached from a marker gets the label of its
+ * catchment basin, and the result is saved in the same format as the
+ * markers, so that it can be fed back to the tools reading labels.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#include <bcl.h>
+#include <flooding.h>
+
+void
+usage(char* s)
+{
+  fprintf(stderr,"%s <ims> <markers> <imd>\n",s);
+  exit(EXIT_FAILURE);
+}
+
+#define PARAM 3
+int
+main(int argc, char* argv[])
+{
+  if(argc != PARAM+1) usage(argv[0]);
+  pnm ims     = pnm_load(argv[1]);
+  pnm markers = pnm_load(argv[2]);
+  int w       = pnm_get_width(ims);
+  int h       = pnm_get_height(ims);
+
+  if(pnm_get_width(markers) != w || pnm_get_height(markers) != h){
+    fprintf(stderr, "%s: the markers and the image differ in size\n", argv[0]);
+    exit(EXIT_FAILURE);
+  }
+
+  unsigned short *ps     = pnm_get_image(ims);
+  unsigned short *pm     = pnm_get_image(markers);
+  unsigned char  *levels = memory_alloc(w*h);
+  int            *labels = memory_alloc(w*h*sizeof(int));
+
+  for(int p = 0; p < w*h; p++, ps += 3, pm += 3){
+    levels[p] = (unsigned char)ps[0];
+    labels[p] = (pm[0] & 0xff) << 16 | (pm[1] & 0xff) << 8 | (pm[2] & 0xff);
+  }
+
+  int flooded   = watershed(w, h, levels, labels);
+  int unreached = 0;
+  for(int p = 0; p < w*h; p++)
+    unreached += labels[p] == 0;
+  fprintf(stderr, "watershed: %d pixels flooded, %d left unreached\n",
+	  flooded, unreached);
+
+  pnm             imd = pnm_new(w, h, PnmRawPpm);
+  unsigned short *pd  = pnm_get_image(imd);
+  for(int p = 0; p < w*h; p++){
+    *pd++ = (labels[p] >> 16) & 0xff;
+    *pd++ = (labels[p] >> 8) & 0xff;
+    *pd++ = labels[p] & 0xff;
+  }
+  pnm_save(imd, PnmRawPpm, argv[3]);
+
+  memory_free(levels);
+  memory_free(labels);
+  pnm_free(ims);
+  pnm_free(markers);
+  pnm_free(imd);
+  return EXIT_SUCCESS;
+}
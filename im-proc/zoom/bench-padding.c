@@ -0,0 +1,91 @@
+/**
+ * @file  bench-padding.c
+ * @brief time the zero-padding zoom of padding.c on the given images with
+ *        1 to n FFT threads, the speedup being relative to one thread.
+ *
+ * padding.c is compiled into its own object with its main renamed by the
+ * Makefile, so that do_padding() is linked in the benchmark. Each thread
+ * count runs once outside of the timing to plan the transforms. An output
+ * differing from the single-threaded one (rounding of the transforms) is
+ * flagged with a '*'.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <fft.h>
+
+void
+do_padding(pnm ims, pnm imd, int factor);
+
+double
+now_ms(void)
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return 1000.0*t.tv_sec + t.tv_nsec/1e6;
+}
+
+int
+same(pnm a, pnm b)
+{
+  int n = 3*pnm_get_width(a)*pnm_get_height(a);
+  return !memcmp(pnm_get_image(a), pnm_get_image(b), n*sizeof(unsigned short));
+}
+
+void
+run(char *name, int factor, int threads, int loops)
+{
+  pnm    ims  = pnm_load(name);
+  int    w    = pnm_get_width(ims)*factor;
+  int    h    = pnm_get_height(ims)*factor;
+  pnm    ref  = pnm_new(w, h, PnmRawPpm);
+  pnm    imd  = pnm_new(w, h, PnmRawPpm);
+  double base = 0;
+
+  printf("%s, padded to %dx%d\n", name, w, h);
+  for(int t = 1; t <= threads; t++){
+    if(fft_set_threads(t) != t){
+      printf("  FFTW is not threaded\n");
+      break;
+    }
+    do_padding(ims, t == 1 ? ref : imd, factor);
+    double start = now_ms();
+    for(int k = 0; k < loops; k++)
+      do_padding(ims, imd, factor);
+    double ms = (now_ms()-start)/loops;
+    if(t == 1)
+      base = ms;
+    printf("  %2d threads %10.1f ms  x%.2f%s\n", t, ms, base/ms,
+	   same(ref, imd) ? "" : " *");
+  }
+  pnm_free(ims);
+  pnm_free(ref);
+  pnm_free(imd);
+}
+
+void
+usage(char *s)
+{
+  fprintf(stderr, "%s <factor> <threads> <loops> <ims>...\n", s);
+  exit(EXIT_FAILURE);
+}
+
+int
+main(int argc, char *argv[])
+{
+  if(argc < 5)
+    usage(argv[0]);
+  int factor  = atoi(argv[1]);
+  int threads = atoi(argv[2]);
+  int loops   = atoi(argv[3]);
+  if(factor < 1 || threads < 1 || loops < 1)
+    usage(argv[0]);
+  for(int k = 4; k < argc; k++)
+    run(argv[k], factor, threads, loops);
+  return EXIT_SUCCESS;
+}
@@ -12,11 +12,14 @@
 #include <bcl.h>
 
 /**
- * @brief perform a discrete 2D Fourier transform from grayscale image
+ * @brief perform a discrete 2D Fourier transform from grayscale image, the
+ *        spectrum being centered by a (-1)^(i+j) modulation of the image
+ *        for even sizes, unless FFT_CENTER is swap, and by fft_shift()
+ *        otherwise
  * @param int rows: the input image height
  * @param int cols: the input image widht
  * @param unsigned short* gray_image: the grayscale input image
- * @return the Fourrier transform in frequency domain
+ * @return the centered Fourrier transform in frequency domain
  */
 fftw_complex *
 forward(int rows, int cols, unsigned short *gray_image);
@@ -25,12 +28,24 @@ forward(int rows, int cols, unsigned short *gray_image);
  * @brief perform a discrete inverse 2D Fourier transform from freqency domain
  * @param int rows: the input complex height
  * @param int cols: the input complex width
- * @param fft_complex* freq_repr: the frequency complex input 
+ * @param fft_complex* freq_repr: the centered frequency complex input, kept
+ * @param int factor: the normalizing size
  * @return the grayscale image from inverse Fourier transform
  */
 unsigned short *
 backward(int rows, int cols, fftw_complex *freq_repr, int factor);
 
+/**
+ * @brief shift a spectrum in place so that the null frequency moves from
+ *        (0, 0) to (rows/2, cols/2), or back
+ * @param int rows: the spectrum height
+ * @param int cols: the spectrum width
+ * @param fft_complex* tab: the spectrum, row major
+ * @param int inverse: non-zero to move the null frequency back to (0, 0)
+ */
+void
+fft_shift(int rows, int cols, fftw_complex *tab, int inverse);
+
 /**
  * @brief compute amplitude and phase spectrum from frequency domain
  * @param int rows: the input complex height
@@ -53,4 +68,99 @@ freq2spectra(int rows, int cols, fftw_complex *freq_repr, float *as, float *ps);
 void 
 spectra2freq(int rows, int cols, float* as, float* ps, fftw_complex* freq_repr);
 
+/**
+ * @brief perform a discrete 2D Fourier transform from a grayscale image with
+ *        a real-to-complex transform, keeping only the half spectrum the
+ *        others are the conjugates of
+ * @param int rows: the input image height
+ * @param int cols: the input image width
+ * @param unsigned short* gray_image: the grayscale input image
+ * @return the rows*(cols/2+1) half spectrum, row major
+ */
+fftw_complex *
+forward_r2c(int rows, int cols, unsigned short *gray_image);
+
+/**
+ * @brief perform a discrete inverse 2D Fourier transform from a half
+ *        spectrum with a complex-to-real transform
+ * @param int rows: the output image height
+ * @param int cols: the output image width
+ * @param fft_complex* freq_repr: the rows*(cols/2+1) half spectrum, kept
+ * @param int prev_size: the normalizing size, the number of pixels of the
+ *        transformed image
+ * @return the grayscale image from inverse Fourier transform
+ */
+unsigned short *
+backward_c2r(int rows, int cols, fftw_complex *freq_repr, int prev_size);
+
+/**
+ * @brief perform the discrete 2D Fourier transforms of several grayscale
+ *        planes, such as the channels of a color image, with a single
+ *        real-to-complex plan
+ * @param int rows: the input planes height
+ * @param int cols: the input planes width
+ * @param int howmany: the number of planes
+ * @param unsigned short* planes: the howmany rows*cols planes, one after
+ *        the other
+ * @return the howmany rows*(cols/2+1) half spectra, one after the other
+ */
+fftw_complex *
+forward_r2c_many(int rows, int cols, int howmany, unsigned short *planes);
+
+/**
+ * @brief perform the discrete inverse 2D Fourier transforms of several half
+ *        spectra with a single complex-to-real plan
+ * @param int rows: the output planes height
+ * @param int cols: the output planes width
+ * @param int howmany: the number of planes
+ * @param fft_complex* freq_repr: the howmany rows*(cols/2+1) half spectra,
+ *        one after the other, kept
+ * @param int prev_size: the normalizing size, the number of pixels of a
+ *        transformed plane
+ * @return the howmany grayscale planes, one after the other
+ */
+unsigned short *
+backward_c2r_many(int rows, int cols, int howmany, fftw_complex *freq_repr, int prev_size);
+
+/**
+ * @brief compute the full amplitude and phase spectrum from a half spectrum,
+ *        the other half being mirrored (same amplitude, opposite phase)
+ * @param int rows: the image height
+ * @param int cols: the image width
+ * @param fft_complex* freq_repr: the rows*(cols/2+1) half spectrum
+ * @param float* as: the rows*cols amplitude spectrum output
+ * @param float* ps: the rows*cols phase spectrum output
+ */
+void
+freq2spectra_half(int rows, int cols, fftw_complex *freq_repr, float *as, float *ps);
+
+/**
+ * @brief compute the half spectrum from a full amplitude and phase spectrum,
+ *        only the bins of the half being read
+ * @param int rows: the image height
+ * @param int cols: the image width
+ * @param float* as: the rows*cols amplitude spectrum input
+ * @param float* ps: the rows*cols phase spectrum input
+ * @param fft_complex* freq_repr: the rows*(cols/2+1) half spectrum output
+ */
+void
+spectra2freq_half(int rows, int cols, float* as, float* ps, fftw_complex* freq_repr);
+
+/**
+ * @brief set the number of threads of the transforms planned from now on
+ * @param int n: the number of threads, FFT_THREADS or the number of online
+ *        processors when not positive
+ * @return the number of threads used, 1 when FFTW is not threaded
+ */
+int
+fft_set_threads(int n);
+
+/**
+ * @brief release the cached plans and save the accumulated wisdom, done
+ *        automatically at exit, the wisdom file being loaded again before
+ *        the next plan
+ */
+void
+fft_cleanup(void);
+
 #endif /* FFT_H */
@@ -17,9 +17,9 @@
 void
 set_comp(int cols, int rows, unsigned short* ims, pnm imd, int chan)
 {
-  for (int j = 0; j < cols; j++)
-    for (int i = 0; i < rows; i++)
-        pnm_set_component(imd, i, j, chan, ims[i + (rows*j)]);
+  for (int i = 0; i < rows; i++)
+    for (int j = 0; j < cols; j++)
+        pnm_set_component(imd, i, j, chan, ims[i*cols + j]);
 }
 
 /**
@@ -32,40 +32,73 @@ set_comp(int cols, int rows, unsigned short* ims, pnm imd, int chan)
 void
 get_short_value(int cols, int rows, pnm ims, unsigned short *imd, int c)
 {
-    // Constructing the gray image
-    for (int j = 0; j < cols; j++)
-        for (int i = 0; i < rows; i++){
-            imd[i + (rows*j)] = pnm_get_component(ims, i, j, c); 
-        }
+    // Constructing the gray image, row major as the transforms expect it
+    for (int i = 0; i < rows; i++)
+        for (int j = 0; j < cols; j++)
+            imd[i*cols + j] = pnm_get_component(ims, i, j, c);
 }
 
 /**
- * @brief Computes a gray-scaled image from an input image
- * @param in the number of columns of the input image
- * @param out the number of rows of the input image
- * @param cols the input image
- * @param rows the new gray-scaled image
- * @param factor the new gray-scaled image
+ * @brief Gets the bin of signed frequencies (ku, kv) from a half spectrum
+ * @param half the rows*(cols/2+1) half spectrum
+ * @param cols the number of columns of the image
+ * @param rows the number of rows of the image
+ * @param ku the row frequency
+ * @param kv the column frequency, between -cols/2 and cols/2
+ * @return the bin, from its conjugate for negative column frequencies
+ **/
+static fftw_complex
+half_bin(fftw_complex *half, int cols, int rows, int ku, int kv)
+{
+    if (kv >= 0)
+        return half[((ku + rows) % rows)*(cols/2+1) + kv];
+    return conj(half[((rows - ku) % rows)*(cols/2+1) - kv]);
+}
+
+/**
+ * @brief Zero-pads a half spectrum into the half spectrum of an image
+ *        factor times larger, low frequencies staying at the same place
+ * @param in the rows*(cols/2+1) half spectrum
+ * @param out the (rows*factor)*(cols*factor/2+1) padded half spectrum
+ * @param cols the number of columns of the input image
+ * @param rows the number of rows of the input image
+ * @param factor the scale factor
  **/
 void
-resize_complex_array(fftw_complex *in, fftw_complex *out, int cols, int rows, int factor)
+resize_half_spectrum(fftw_complex *in, fftw_complex *out, int cols, int rows, int factor)
 {
-    // Initializing the zero array
-    for (int j = 0; j < cols*factor; j++)
-        for (int i = 0; i < rows*factor; i++)
-            out[i+(rows*factor*j)]= 0+0*I;
-
-    // Putting the input image at the center
-    int starting_col = cols*factor/2-cols/2;
-    int starting_row = rows*factor/2-rows/2;
-    for (int j = 0; j < cols; j++)
-        for (int i = 0; i < rows; i++)
-            out[(starting_row+i)+(rows*factor*(j+starting_col))]= in[i + j*rows];
+    int prows  = rows*factor;
+    int pcols  = cols*factor;
+    int phcols = pcols/2+1;
+
+    for (int k = 0; k < prows*phcols; k++)
+        out[k] = 0;
+
+    // Frequencies go from -size/2 to (size-1)/2. When padding, the Nyquist
+    // frequency -size/2 of an even size has no positive counterpart, so the
+    // bin is shared between its place and its conjugate one, which keeps
+    // the padded spectrum Hermitian
+    for (int ku = -(rows/2); ku < rows - rows/2; ku++)
+        for (int kv = -(cols/2); kv < cols - cols/2; kv++){
+            fftw_complex c = half_bin(in, cols, rows, ku, kv);
+            int nyquist = factor > 1 &&
+                ((rows % 2 == 0 && ku == -(rows/2)) ||
+                 (cols % 2 == 0 && kv == -(cols/2)));
+            if (nyquist){
+                if (kv >= 0)
+                    out[((ku + prows) % prows)*phcols + kv] += c/2;
+                if (kv <= 0)
+                    out[((prows - ku) % prows)*phcols - kv] += conj(c)/2;
+            }
+            else if (kv >= 0)
+                out[((ku + prows) % prows)*phcols + kv] = c;
+        }
 }
 
 
 /**
- * @brief Computes the padding of an image, depending on a factor
+ * @brief Computes the padding of an image, depending on a factor, the three
+ *        channels being transformed together
  * @param ims the input image
  * @param imd the new image after padding
  * @param factor the scale factor
@@ -73,30 +106,32 @@ resize_complex_array(fftw_complex *in, fftw_complex *out, int cols, int rows, in
 void
 do_padding(pnm ims, pnm imd, int factor)
 {
-    int cols = pnm_get_width(ims);
-    int rows = pnm_get_height(ims);
+    int cols  = pnm_get_width(ims);
+    int rows  = pnm_get_height(ims);
+    int half  = rows*(cols/2+1);
+    int phalf = rows*factor*(cols*factor/2+1);
 
-    unsigned short *g_img = malloc(rows*cols*sizeof(unsigned short));
+    unsigned short *g_img = malloc(3*rows*cols*sizeof(unsigned short));
 
-    fftw_complex * comp = (fftw_complex *) malloc((rows*factor*cols*factor)*sizeof(fftw_complex));
+    fftw_complex * comp = (fftw_complex *) malloc(3*phalf*sizeof(fftw_complex));
 
-    for(int chan=0; chan<3; chan++){
+    for(int chan=0; chan<3; chan++)
+        get_short_value(cols, rows, ims, g_img + chan*rows*cols, chan);
 
-        get_short_value(cols, rows, ims, g_img, chan);
+    fftw_complex *precomp = forward_r2c_many(rows, cols, 3, g_img);
 
-        fftw_complex *precomp = forward(rows, cols, g_img);
+    for(int chan=0; chan<3; chan++)
+        resize_half_spectrum(precomp + chan*half, comp + chan*phalf, cols, rows, factor);
 
-        resize_complex_array(precomp,comp,cols,rows,factor);
+    unsigned short *new_g_img = backward_c2r_many(rows*factor, cols*factor, 3, comp, cols*rows);
 
-        unsigned short *new_g_img = backward(rows*factor, cols*factor, comp, cols*rows);
+    for(int chan=0; chan<3; chan++)
+        set_comp(cols*factor, rows*factor, new_g_img + chan*rows*cols*factor*factor, imd, chan);
 
-        set_comp(cols*factor,rows*factor, new_g_img, imd, chan); 
-        
-        free(precomp);
-        free(new_g_img);   
-    }
-        free(g_img);
-        free(comp);
+    free(precomp);
+    free(new_g_img);
+    free(g_img);
+    free(comp);
 }
 
 void
@@ -0,0 +1,139 @@
+/**
+ * @file test-fft.c
+ * @brief check the centered spectra of forward() and backward() in both
+ *        FFT_CENTER modes, for even, odd and mixed sizes cropped from the
+ *        given images
+ *
+ * The spectra of the modulate and swap modes must be the same, and equal
+ * to the uncentered half spectrum of forward_r2c() moved by (rows/2,
+ * cols/2). backward() must give the image back in both modes, without
+ * changing the spectrum given to it.
+ */
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include <fft.h>
+
+#define EPSILON 1e-9
+
+static int failures = 0;
+
+/**
+ * @brief the gray-scale image of the top left rows x cols corner
+ */
+unsigned short *
+crop_gray(pnm img, int rows, int cols)
+{
+  unsigned short *g = malloc(rows*cols*sizeof(unsigned short));
+  for(int i = 0; i < rows; i++)
+    for(int j = 0; j < cols; j++)
+      g[i*cols + j] = (pnm_get_component(img, i, j, 0) +
+		       pnm_get_component(img, i, j, 1) +
+		       pnm_get_component(img, i, j, 2))/3;
+  return g;
+}
+
+void
+check(int ok, char *what, int rows, int cols, char *mode)
+{
+  if(!ok){
+    fprintf(stderr, "FAIL: %s, %dx%d, %s\n", what, rows, cols, mode);
+    failures++;
+  }
+}
+
+/**
+ * @brief run forward() and backward() in both modes on a rows x cols image
+ */
+void
+test_center(pnm img, int rows, int cols)
+{
+  static char    *modes[] = {"modulate", "swap"};
+  unsigned short *g       = crop_gray(img, rows, cols);
+  int             hcols   = cols/2+1;
+  fftw_complex   *half    = forward_r2c(rows, cols, g);
+  fftw_complex   *spectra[2];
+  int             before  = failures;
+  // The spectrum is bounded by the sum of the image
+  double          tol     = EPSILON*255*rows*cols;
+
+  for(int m = 0; m < 2; m++){
+    setenv("FFT_CENTER", modes[m], 1);
+    fftw_complex *freq = forward(rows, cols, g);
+    spectra[m] = freq;
+
+    double err = 0;
+    for(int u = 0; u < rows; u++)
+      for(int v = 0; v < hcols; v++){
+	int    i = (u + rows/2) % rows;
+	int    j = (v + cols/2) % cols;
+	double e = cabs(freq[i*cols + j] - half[u*hcols + v]);
+	err = e > err ? e : err;
+      }
+    check(err < tol, "centered spectrum", rows, cols, modes[m]);
+
+    fftw_complex *copy = malloc(rows*cols*sizeof(fftw_complex));
+    memcpy(copy, freq, rows*cols*sizeof(fftw_complex));
+    unsigned short *back = backward(rows, cols, freq, rows*cols);
+    check(!memcmp(copy, freq, rows*cols*sizeof(fftw_complex)),
+	  "spectrum kept by backward", rows, cols, modes[m]);
+    int diff = 0;
+    for(int p = 0; p < rows*cols; p++)
+      diff = abs(back[p] - g[p]) > diff ? abs(back[p] - g[p]) : diff;
+    // backward truncates the values
+    check(diff <= 1, "image given back", rows, cols, modes[m]);
+    free(copy);
+    free(back);
+  }
+
+  double err = 0;
+  for(int p = 0; p < rows*cols; p++){
+    double e = cabs(spectra[0][p] - spectra[1][p]);
+    err = e > err ? e : err;
+  }
+  check(err < tol, "same spectrum in both modes", rows, cols, "both");
+  fprintf(stderr, "test_center %dx%d: %s\n", rows, cols,
+	  failures > before ? "FAIL" : "OK");
+
+  unsetenv("FFT_CENTER");
+  free(spectra[0]);
+  free(spectra[1]);
+  free(half);
+  free(g);
+}
+
+void
+run(char *name)
+{
+  pnm img  = pnm_load(name);
+  int cols = pnm_get_width(img);
+  int rows = pnm_get_height(img);
+
+  fprintf(stderr, "%s\n", name);
+  // Even, odd and mixed sizes
+  test_center(img, rows - rows%2, cols - cols%2);
+  test_center(img, rows - 1 + rows%2, cols - 1 + cols%2);
+  test_center(img, rows - rows%2, cols - 1 + cols%2);
+  pnm_free(img);
+}
+
+void
+usage(const char *s)
+{
+  fprintf(stderr, "Usage: %s <ims>...\n", s);
+  exit(EXIT_FAILURE);
+}
+
+int
+main(int argc, char *argv[])
+{
+  if(argc < 2)
+    usage(argv[0]);
+  for(int k = 1; k < argc; k++)
+    run(argv[k]);
+  return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}